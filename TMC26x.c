@@ -54,9 +54,6 @@ uint32_t setTMC26xDRVCTRL(uint8_t interpol, uint8_t doubleEdge, uint16_t microst
 #define VSENSE_165MV 0x1ul // 0 = 305mV, 1 = 165mV
 #define VSENSE_305MV 0x0ul // 0 = 305mV, 1 = 165mV
 #define VSENSE_SHIFT 6  // bit shift ammount
-#define READOUT_VALUE_MS_POS 0 // 0 = microstep position, 1 = Stallguard2, 2 = SG2 + Coolstep, 3 = don't use 
-#define READOUT_VALUE_SG2 1 
-#define READOUT_VALUE_SG2_COOLSTEP 2
 #define READOUT_VALUE_SHIFT 4 // bit shift ammount
 #define SG2_FILTER_DISABLE 0
 #define SG2_FILTER_ENABLE 1
@@ -89,67 +86,135 @@ uint32_t setTMC26xDRVCTRL(uint8_t interpol, uint8_t doubleEdge, uint16_t microst
 #define CARVEY_STALL_GAURD_THRESHOLD 10 
 
 
-void tmc26x_init()
+// SPI status bits, in the low byte of every 20 bit response
+#define TMC26X_STATUS_SG   0x01  // stallGuard2 threshold reached
+#define TMC26X_STATUS_OT   0x02  // over temperature shutdown
+#define TMC26X_STATUS_OTPW 0x04  // over temperature pre-warning
+#define TMC26X_STATUS_S2GA 0x08  // short to ground, coil A
+#define TMC26X_STATUS_S2GB 0x10  // short to ground, coil B
+#define TMC26X_STATUS_FAULT (TMC26X_STATUS_OT | TMC26X_STATUS_S2GA | TMC26X_STATUS_S2GB)
+#define TMC26X_NO_RESPONSE 0xFFFFFul  // MISO not driven, the chip isn't there or isn't powered
+#define TMC26X_NO_RESPONSE_LOW 0ul     // same, when a floating MISO (no pull-up) reads low
+
+#define TMC26X_POWER_UP_DELAY_MS 2  // one settling time for all drivers before the first datagram
+#define TMC26X_RETRY_DELAY_MS 5     // wait before reconfiguring drivers that didn't answer
+#define TMC26X_RETRIES 20           // give up on a driver after about 100 msec
+
+#define TMC26X_N_CONFIG_REGISTERS 5  // CHOPCONF, SMARTEN, SGSCONF, DRVCONF, DRVCTRL
+
+uint8_t tmc26x_ready_mask = 0;
+volatile uint32_t tmc26x_response[N_AXIS];  // latest response of each driver, see tmc26x_request_status()
+
+static const uint8_t tmc26x_cs_bit[N_AXIS] = { CS_X_BIT, CS_Y_BIT, CS_Z_BIT };
+static const uint8_t tmc26x_run_current[N_AXIS] = { X_RUN_CURRENT, Y_RUN_CURRENT, Z_RUN_CURRENT };
+static const uint16_t tmc26x_microsteps[N_AXIS] = { X_MICROSTEPS, Y_MICROSTEPS, Z_MICROSTEPS };
+
+
+// the datagram for one of the configuration registers of an axis driver, in the order they are sent
+static uint32_t tmc26x_config_datagram(uint8_t reg, uint8_t axis)
 {
-  uint8_t csBit;
-  
+  switch (reg)
+  {
+    case 0: return setTMC26xCHOPCONF(CARVEY_CHOPPER_BLANKING_TIME, CHOPPER_MODE_STANDARD, CARVEY_RANDOM_TIME_OFF);
+    case 1: return setTMC26xSMARTEN(MIN_COOL_CURRENT_HALF);
+    case 2: return setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, tmc26x_run_current[axis]);
+    case 3: return setTMC26xDRVCONF(READOUT_VALUE_SG2);
+    default: return setTMC26xDRVCTRL(STEP_ITERPOL_DISABLE, DOUBLE_EDGE_DISABLE, tmc26x_microsteps[axis]);
+  }
+}
+
+
+// Configures all drivers together. Each register goes out to every pending driver before the next
+// register is sent, so one settling delay covers all of them instead of one per driver. A driver
+// answers every datagram with its status, so the response to a final DRVCONF read back confirms
+// it latched the configuration. MISO has no pull-up, so an absent driver may read all ones or all
+// zeroes. Both are rejected. A powered driver at standstill sets the standstill status bit within
+// the retry time, so its response can't stay all zeroes. Drivers that didn't answer cleanly are
+// retried, rather than waiting a fixed time up front for the slowest case. Returns the mask of
+// configured drivers.
+uint8_t tmc26x_init()
+{
+  uint8_t pending = (1<<N_AXIS)-1;  // drivers still to configure, one bit per axis
+  uint8_t retries = 0;
+  uint8_t reg, idx;
+  uint32_t response;
+
   CS_DDR |= CS_MASK;  // set them as outputs
-  CS_PORT |= (1<<CS_MASK); // make them high (chips not selected)
-  
-  
+  CS_PORT |= CS_MASK; // make them high (chips not selected)
+
   spi_init();  // initialize the SPI port
-  
- 
-  
-  // setup x axis driver
-  csBit = CS_X_BIT;
-  delay_ms(20);  // give a little time before SPI starts
-  spi_send20bit(setTMC26xCHOPCONF(CARVEY_CHOPPER_BLANKING_TIME, CHOPPER_MODE_STANDARD, CARVEY_RANDOM_TIME_OFF), &CS_PORT, csBit);
-  spi_send20bit(setTMC26xSMARTEN(MIN_COOL_CURRENT_HALF), &CS_PORT, csBit);
-  spi_send20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, X_RUN_CURRENT), &CS_PORT, csBit);
-  spi_send20bit( setTMC26xDRVCONF(READOUT_VALUE_SG2), &CS_PORT, csBit);
-  spi_send20bit( setTMC26xDRVCTRL(STEP_ITERPOL_DISABLE,DOUBLE_EDGE_DISABLE,X_MICROSTEPS), &CS_PORT, csBit);
-  
-  // setup Y axis driver
-  csBit = CS_Y_BIT;
-  delay_ms(20); // give a little time before SPI starts
-  spi_send20bit(setTMC26xCHOPCONF(CARVEY_CHOPPER_BLANKING_TIME, CHOPPER_MODE_STANDARD, CARVEY_RANDOM_TIME_OFF), &CS_PORT, csBit);
-  spi_send20bit(setTMC26xSMARTEN(MIN_COOL_CURRENT_HALF), &CS_PORT, csBit);
-  spi_send20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, Y_RUN_CURRENT), &CS_PORT, csBit);
-  spi_send20bit( setTMC26xDRVCONF(READOUT_VALUE_SG2), &CS_PORT, csBit);
-  spi_send20bit( setTMC26xDRVCTRL(STEP_ITERPOL_DISABLE,DOUBLE_EDGE_DISABLE,Y_MICROSTEPS), &CS_PORT, csBit);
-  
- 
-  
-  // setup x axis driver
-  csBit = CS_Z_BIT;
-  delay_ms(20); // give a little time before SPI starts
-  spi_send20bit(setTMC26xCHOPCONF(CARVEY_CHOPPER_BLANKING_TIME, CHOPPER_MODE_STANDARD, CARVEY_RANDOM_TIME_OFF), &CS_PORT, csBit);
-  spi_send20bit(setTMC26xSMARTEN(MIN_COOL_CURRENT_HALF), &CS_PORT, csBit);
-  spi_send20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, Z_RUN_CURRENT), &CS_PORT, csBit);
-  spi_send20bit( setTMC26xDRVCONF(READOUT_VALUE_SG2), &CS_PORT, csBit);
-  spi_send20bit( setTMC26xDRVCTRL(STEP_ITERPOL_DISABLE,DOUBLE_EDGE_DISABLE,Z_MICROSTEPS), &CS_PORT, csBit);
-  
+
+  delay_ms(TMC26X_POWER_UP_DELAY_MS);  // give a little time before SPI starts
+
+  for (;;)
+  {
+    for (reg=0; reg<TMC26X_N_CONFIG_REGISTERS; reg++)
+    {
+      for (idx=0; idx<N_AXIS; idx++)
+      {
+        if (bit_istrue(pending, bit(idx))) { spi_queue20bit(tmc26x_config_datagram(reg, idx), &CS_PORT, tmc26x_cs_bit[idx], NULL); }
+      }
+    }
+
+    for (idx=0; idx<N_AXIS; idx++)
+    {
+      if (bit_istrue(pending, bit(idx)))
+      {
+        response = spi_send20bit(setTMC26xDRVCONF(READOUT_VALUE_SG2), &CS_PORT, tmc26x_cs_bit[idx]);
+        if ((response != TMC26X_NO_RESPONSE) && (response != TMC26X_NO_RESPONSE_LOW) &&
+            !(response & TMC26X_STATUS_FAULT)) { bit_false(pending, bit(idx)); }
+      }
+    }
+
+    if (!pending || (++retries > TMC26X_RETRIES)) { break; }
+    delay_ms(TMC26X_RETRY_DELAY_MS);
+  }
+
+  tmc26x_ready_mask = ((1<<N_AXIS)-1) & ~pending;
+  return tmc26x_ready_mask;
 }
 
 
+// queues the current change and returns, so waking up the steppers doesn't wait on the SPI
 void setTMC26xRunCurrent(uint8_t level)  // 1 = run, 0 = idle
 {
 	if (level == 1)
 	{	
-		spi_send20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, X_RUN_CURRENT), &CS_PORT, CS_X_BIT);
-		spi_send20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, Y_RUN_CURRENT), &CS_PORT, CS_Y_BIT);
-		spi_send20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, Z_RUN_CURRENT), &CS_PORT, CS_Z_BIT);
+		spi_queue20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, X_RUN_CURRENT), &CS_PORT, CS_X_BIT, NULL);
+		spi_queue20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, Y_RUN_CURRENT), &CS_PORT, CS_Y_BIT, NULL);
+		spi_queue20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, Z_RUN_CURRENT), &CS_PORT, CS_Z_BIT, NULL);
 	}
 	else 
 	{
-		spi_send20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, X_IDLE_CURRENT), &CS_PORT, CS_X_BIT);
-		spi_send20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, Y_IDLE_CURRENT), &CS_PORT, CS_Y_BIT);
-		spi_send20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, Z_IDLE_CURRENT), &CS_PORT, CS_Z_BIT);
+		spi_queue20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, X_IDLE_CURRENT), &CS_PORT, CS_X_BIT, NULL);
+		spi_queue20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, Y_IDLE_CURRENT), &CS_PORT, CS_Y_BIT, NULL);
+		spi_queue20bit(setTMC26xSGSCONF(SG2_FILTER_ENABLE, CARVEY_STALL_GAURD_THRESHOLD, Z_IDLE_CURRENT), &CS_PORT, CS_Z_BIT, NULL);
 	}
 }
 
 
+// spi callback. stores the latest response of a driver
+static void tmc26x_status_callback(uint8_t cs_bit, unsigned long response)
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++)
+  {
+    if (tmc26x_cs_bit[idx] == cs_bit) { tmc26x_response[idx] = response; }
+  }
+}
+
+
+// queues a read of every driver. the responses land in tmc26x_response[] in the background
+void tmc26x_request_status(uint8_t readItem)
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++)
+  {
+    spi_queue20bit(setTMC26xDRVCONF(readItem), &CS_PORT, tmc26x_cs_bit[idx], tmc26x_status_callback);
+  }
+}
+
+
 unsigned long readValue(uint8_t readItem)
  {
     return  spi_send20bit( setTMC26xDRVCONF(readItem), &CS_PORT, CS_X_BIT);
@@ -325,7 +390,7 @@ uint32_t setTMC26xDRVCONF(uint8_t readItem)
    if (readItem > READOUT_VALUE_SG2_COOLSTEP)
     readItem = READOUT_VALUE_SG2;
  
-   regVal |= (READOUT_VALUE_SG2 << READOUT_VALUE_SHIFT);
+   regVal |= ((uint32_t)readItem << READOUT_VALUE_SHIFT);
  
   
   
@@ -411,9 +476,22 @@ uint32_t setTMC26xDRVCTRL(uint8_t interpol, uint8_t doubleEdge, uint16_t microst
    return regVal;
 }
 
-unsigned long tmc26xStallGuardReading()
+// microstep resolution an axis driver is configured with
+uint16_t tmc26x_get_microsteps(uint8_t axis)
 {
-  
+  return tmc26x_microsteps[axis];
+}
+
+
+// latest stallGuard2 reading of an axis driver, from tmc26x_request_status(READOUT_VALUE_SG2).
+// 0 to 1023, lower is more load. 0 is a stall at the configured threshold
+uint16_t tmc26xStallGuardReading(uint8_t axis)
+{
+  uint8_t sreg = SREG;
+  cli();
+  uint32_t response = tmc26x_response[axis];
+  SREG = sreg;
+  return ((response >> 10) & 0x3FF);
 }
 
 
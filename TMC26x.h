@@ -1,7 +1,18 @@
 #ifndef TMC26X_H
 #define TMC26X_H
 
-extern void tmc26x_init();
-extern void setTMC26xRunCurrent(uint8_t);
+#define READOUT_VALUE_MS_POS 0 // 0 = microstep position, 1 = Stallguard2, 2 = SG2 + Coolstep, 3 = don't use 
+#define READOUT_VALUE_SG2 1 
+#define READOUT_VALUE_SG2_COOLSTEP 2
+
+extern uint8_t tmc26x_ready_mask;  // drivers that read back after configuration. bit per axis
+
+extern uint8_t tmc26x_init();  // configures all drivers, returns tmc26x_ready_mask
+extern void setTMC26xRunCurrent(uint8_t);  // 1 = run, 0 = idle. queued, doesn't wait on the SPI
+
+extern volatile uint32_t tmc26x_response[N_AXIS];  // latest 20 bit response of each driver
+extern void tmc26x_request_status(uint8_t readItem);  // queue a DRVCONF read of all drivers
+extern uint16_t tmc26xStallGuardReading(uint8_t axis);  // SG value of the latest response
+extern uint16_t tmc26x_get_microsteps(uint8_t axis);  // steps per full step of an axis
 
 #endif
@@ -0,0 +1,135 @@
+/*
+  binary_motion.c - compact framed motion streaming
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  Binary motion mode is toggled by the '$B' system command and is cleared by a reset. While
+  active, every line that does not start with '$' is one motion frame. Frames are encoded with
+  the standard base64 alphabet, without padding, so they never contain the realtime command
+  characters picked off by the serial RX ISR or an end-of-line. Feed hold, cycle start, status
+  reports, overrides, and reset all continue to work in the middle of a binary stream.
+
+  Decoded frame layout:
+    [header] [axis values...] [feed rate] [checksum]
+    - header: BM_HEADER bit map. Reserved bits must be zero.
+    - axis values: signed 24-bit little-endian, BM_COORD_SCALE mm per count, for each axis
+      flagged in the header, in axis order. Interpreted under the current distance mode and
+      work coordinate system, exactly like an axis word in a g-code block.
+    - feed rate: unsigned 24-bit little-endian, BM_FEED_RATE_SCALE mm/min per count. Modal.
+    - checksum: chosen such that the XOR of all frame bytes is zero.
+
+  Each frame is acknowledged with an 'ok' or 'error:' like a g-code line, so character-counting
+  streaming protocols work unchanged. A typical three axis move is 15 characters plus the
+  end-of-line on the wire.
+*/
+
+#include "grbl.h"
+
+#ifdef ENABLE_BINARY_MOTION_STREAM
+
+static uint32_t bm_read_uint24(uint8_t *data)
+{
+  return( ((uint32_t)data[2] << 16) | ((uint16_t)data[1] << 8) | data[0] );
+}
+
+
+static int32_t bm_read_int24(uint8_t *data)
+{
+  uint32_t value = bm_read_uint24(data);
+  if (value & 0x00800000) { value |= 0xFF000000; } // Sign extend
+  return((int32_t)value);
+}
+
+
+// Decodes and executes one binary motion frame line. The frame is planned through mc_line()
+// with the same modal semantics as an equivalent G0/G1 block, and the g-code parser state is
+// updated so text g-code may resume at any time.
+uint8_t bm_execute_frame(char *line)
+{
+  uint8_t frame[BM_FRAME_MAX_SIZE];
+  uint8_t frame_size = read_base64(line, frame, BM_FRAME_MAX_SIZE);
+  if (frame_size < 2) { return(STATUS_BINARY_FRAME_INVALID); }
+
+  // Validate header, frame length, and checksum before touching any parser state.
+  uint8_t header = frame[0];
+  if (header & ~BM_HEADER_VALID_MASK) { return(STATUS_BINARY_FRAME_INVALID); }
+  uint8_t idx;
+  uint8_t expected_size = 2;
+  for (idx=0; idx<N_AXIS; idx++) {
+    if (bit_istrue(header,bit(idx))) { expected_size += 3; }
+  }
+  if (header & BM_HEADER_FEED_RATE) { expected_size += 3; }
+  if (frame_size != expected_size) { return(STATUS_BINARY_FRAME_INVALID); }
+  uint8_t checksum = 0;
+  for (idx=0; idx<frame_size; idx++) { checksum ^= frame[idx]; }
+  if (checksum) { return(STATUS_BINARY_FRAME_INVALID); }
+
+  // Inverse time feed rates must be passed with every block. Not supported by binary frames.
+  if (gc_state.modal.feed_rate == FEED_RATE_MODE_INVERSE_TIME) { return(STATUS_GCODE_UNSUPPORTED_COMMAND); }
+
+  // Compute target in absolute machine coordinates, as the g-code parser does for axis words.
+  float target[N_AXIS];
+  uint8_t *data = &frame[1];
+  for (idx=0; idx<N_AXIS; idx++) {
+    if (bit_isfalse(header,bit(idx))) {
+      target[idx] = gc_state.position[idx];
+    } else {
+      target[idx] = bm_read_int24(data)*BM_COORD_SCALE;
+      data += 3;
+      if (gc_state.modal.distance == DISTANCE_MODE_ABSOLUTE) {
+        target[idx] += gc_state.coord_system[idx] + gc_state.coord_offset[idx];
+        if (idx == TOOL_LENGTH_OFFSET_AXIS) { target[idx] += gc_state.tool_length_offset; }
+      } else {
+        target[idx] += gc_state.position[idx];
+      }
+    }
+  }
+
+  float feed_rate = gc_state.feed_rate;
+  if (header & BM_HEADER_FEED_RATE) { feed_rate = bm_read_uint24(data)*BM_FEED_RATE_SCALE; }
+  if (!(header & BM_HEADER_RAPID) && (feed_rate == 0.0)) { return(STATUS_GCODE_UNDEFINED_FEED_RATE); }
+
+  // Frame is valid. Update modal state and plan the motion.
+  gc_state.feed_rate = feed_rate;
+  if (header & BM_HEADER_RAPID) { gc_state.modal.motion = MOTION_MODE_SEEK; }
+  else { gc_state.modal.motion = MOTION_MODE_LINEAR; }
+  if (!(header & BM_HEADER_AXIS_MASK)) { return(STATUS_OK); } // Modal update only.
+
+  plan_line_data_t plan_data;
+  plan_line_data_t *pl_data = &plan_data;
+  memset(pl_data,0,sizeof(plan_line_data_t));
+  pl_data->feed_rate = gc_state.feed_rate;
+  #ifdef USE_LINE_NUMBERS
+    pl_data->line_number = gc_state.line_number;
+  #endif
+  pl_data->condition = gc_state.modal.spindle | gc_state.modal.coolant;
+  if (header & BM_HEADER_RAPID) {
+    pl_data->condition |= PL_COND_FLAG_RAPID_MOTION;
+    // NOTE: Laser mode disables the laser during G0 motions. Pass zero spindle speed.
+    if (bit_isfalse(settings.flags,BITFLAG_LASER_MODE)) { pl_data->spindle_speed = gc_state.spindle_speed; }
+  } else {
+    pl_data->spindle_speed = gc_state.spindle_speed;
+  }
+
+  mc_line(target, pl_data);
+  memcpy(gc_state.position, target, sizeof(target));
+  return(STATUS_OK);
+}
+
+#endif
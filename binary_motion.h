@@ -0,0 +1,41 @@
+/*
+  binary_motion.h - compact framed motion streaming
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef binary_motion_h
+#define binary_motion_h
+
+// Binary motion frame header bit map. The low bits flag which axis values follow the header,
+// in axis order, as signed 24-bit little-endian integers.
+#define BM_HEADER_AXIS_MASK   ((1<<N_AXIS)-1)
+#define BM_HEADER_FEED_RATE   bit(3) // Unsigned 24-bit feed rate follows the axis values.
+#define BM_HEADER_RAPID       bit(4) // G0 motion. Otherwise G1.
+#define BM_HEADER_VALID_MASK  (BM_HEADER_AXIS_MASK|BM_HEADER_FEED_RATE|BM_HEADER_RAPID)
+
+// Fixed-point scaling of frame values. Targets are always in mm, regardless of G20/G21.
+#define BM_COORD_SCALE     0.001 // mm per count
+#define BM_FEED_RATE_SCALE 0.01  // mm/min per count
+
+// Largest decoded frame: header, all axis values, feed rate, and checksum.
+#define BM_FRAME_MAX_SIZE (1+3*N_AXIS+3+1)
+
+// Decodes and executes one binary motion frame line. Returns a status code like gc_execute_line().
+uint8_t bm_execute_frame(char *line);
+
+#endif
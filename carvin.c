@@ -22,6 +22,36 @@
 #define HRDW_ID_MASK     (1<<HRDW_ID_0 | 1<<HRDW_ID_1 | 1<<HRDW_ID_2 | 1<<HRDW_ID_3 | 1<<HRDW_ID_4) 
 
 int control_button_counter = 0;  // initialize this for use in button debouncing
+volatile uint16_t carvin_tick_count = 0;  // time base for main program timeouts...see CARVIN_TICKS_PER_SECOND
+
+static volatile uint16_t auto_report_interval = 0;  // status auto report interval in timer5 ticks. 0 = disabled
+static uint16_t auto_report_counter = 0;  // ticks until the next status auto report
+static uint8_t auto_report_state = STATE_IDLE;  // last state seen by the status auto report
+
+uint16_t carvin_boot_time_ms = 0;  // power up to the first banner. 0 until then
+static uint16_t boot_timer_count = 0;  // timer5 counts from power up to carvin_init, at clock/1024
+
+static volatile uint8_t overcurrent_report = 0;  // set by timer5 when the spindle current trips
+static float overcurrent_amps;  // the tripping current, reported by the main program
+static uint8_t settings_generation = 0;  // product settings generation last applied
+
+#ifdef ENABLE_MOTOR_LOAD_TELEMETRY
+  #define MOTOR_LOAD_POLL_TICKS 4  // timer5 ticks between driver reads (~130 hz)
+  #define MOTOR_LOAD_BLANK_POLLS 8  // polls an axis must be moving before its readings count
+  #define MOTOR_LOAD_FILTER_SHIFT 2  // each reading moves the filtered value 1/4 of the way
+  #define MOTOR_LOAD_SG_MAX 1023  // reading with no load
+
+  static uint8_t motor_load_counter = 0;  // ticks until the next driver read
+  static int32_t motor_load_position[N_AXIS];  // axis positions at the last read
+  static uint8_t motor_load_moving[N_AXIS];  // consecutive reads the axis was moving fast enough
+  static uint16_t motor_load_filtered[N_AXIS];  // filtered reading, times 16
+  static volatile uint16_t motor_load_margin = 0;  // stall margin ($805). 0 = disabled
+  static volatile uint8_t motor_load_action = 0;  // 0 = feed hold, 1 = alarm ($806)
+  static volatile uint8_t motor_stall_report = 0;  // set by timer5 on a stall, axis number + 1
+  static uint16_t motor_stall_sg;  // the stalling reading, reported by the main program
+
+  static void carvin_motor_load_proc();
+#endif
 
 // setup routine for a Carvin Controller
 void carvin_init()
@@ -42,6 +72,14 @@ void carvin_init()
   
   tmc26x_init();  // SPI functions to program the chips
 
+  carvin_auto_report_init();
+  #ifdef ENABLE_MOTOR_LOAD_TELEMETRY
+    carvin_motor_load_init();
+    uint8_t idx;
+    for (idx=0; idx<N_AXIS; idx++) { motor_load_filtered[idx] = (MOTOR_LOAD_SG_MAX << 4); }
+  #endif
+  settings_generation = ps_settings_get_generation();
+
   // -------------- Setup PWM on Timer 4 ------------------------------
 
   //  Setup PWM For LEDs
@@ -66,8 +104,10 @@ void carvin_init()
   // ---------------- TIMER5 ISR SETUP --------------------------
 
   // Setup a timer5 interrupt to handle timing of things like LED animations and spindle soft start in the background
+  boot_timer_count = TCNT5;  // boot time so far, before the timer is repurposed
   TCCR5A = 0;     // Clear entire TCCR1A register
   TCCR5B = 0;     // Clear entire TCCR1B register
+  TCNT5 = 0;      // carvin_get_timer_count() now counts from here
 
   TCCR5B |= (1 << WGM52);  // turn on CTC mode:
   TCCR5B |= (1 << CS52);   // divide clock/256
@@ -87,9 +127,23 @@ void carvin_init()
   // fade on the button and door LEDs at startup
   set_pwm(&button_led, BUTTON_LED_LEVEL_ON,BUTTON_LED_RISE_TIME);
   set_pwm(&door_led, DOOR_LED_LEVEL_IDLE,DOOR_LED_RISE_TIME);
+}
 
-  setTMC26xRunCurrent(1);
-  
+// first thing at power up. runs timer5 free at clock/1024 (64 usec, 4 seconds to overflow) so the
+// boot time can be measured before interrupts are on. carvin_init takes the timer over
+void carvin_boot_timer_start()
+{
+  TCCR5A = 0;
+  TCNT5 = 0;
+  TCCR5B = (1 << CS52) | (1 << CS50);  // normal mode, divide clock/1024
+}
+
+// called before each banner. latches the time from power up to the first one
+void carvin_record_boot_time()
+{
+  if (carvin_boot_time_ms) { return; }
+  uint32_t usec = (uint32_t)boot_timer_count*(1024000000UL/F_CPU) + carvin_get_elapsed_us(0, carvin_get_timer_count());
+  carvin_boot_time_ms = max(usec/1000, 1);
 }
 
 // Timer5 Interrupt
@@ -98,8 +152,33 @@ void carvin_init()
 //  LED Animations
 //  Spindle Softstart
 //  Button debounce
+//  Tick count
+//  Status auto report
+//  Motor load telemetry
 ISR(TIMER5_COMPA_vect)
 {
+  carvin_tick_count++;
+
+  // status auto report. push one right away on a state change, then keep a fixed cadence
+  // while in motion. the report itself is printed by the main program, like a '?' request.
+  if (auto_report_interval)
+  {
+    if (sys.state != auto_report_state)
+    {
+      auto_report_state = sys.state;
+      auto_report_counter = auto_report_interval;
+      system_set_exec_state_flag(EXEC_STATUS_REPORT);
+    }
+    else if (sys.state & AUTO_REPORT_MOTION_STATES)
+    {
+      if (--auto_report_counter == 0)
+      {
+        auto_report_counter = auto_report_interval;
+        system_set_exec_state_flag(EXEC_STATUS_REPORT);
+      }
+    }
+  }
+
   // see if the led values need to change
   if (pwm_level_change(&button_led))
   {
@@ -127,6 +206,12 @@ ISR(TIMER5_COMPA_vect)
     SPINDLE_MOTOR_OCR = spindle_motor.current_level;
   }
 
+  // the rest can take a while (spindle current math, driver reads). let the serial and stepper
+  // interrupts in meanwhile, so high baud rates don't overrun the usart. mask ourselves so we
+  // can't nest if it runs long. nothing below prints. messages are flagged for the main program.
+  TIMSK5 &= ~(1 << OCIE5A);
+  sei();
+
   if (control_button_counter > 0)
   {
     control_button_counter--;
@@ -138,11 +223,216 @@ ISR(TIMER5_COMPA_vect)
   
   if ( spindle_current_proc() )
   {
-    printPgmString(PSTR("[OverCurrent:"));
-    printFloat(spindle_current_get(), 2);
-    printPgmString(PSTR("]\r\n"));
+    // serial output is main program only. the report goes out with the safety door handling
+    overcurrent_amps = spindle_current_get();
+    overcurrent_report = 1;
     system_set_exec_state_flag(EXEC_SAFETY_DOOR);
   }
+
+  #ifdef ENABLE_MOTOR_LOAD_TELEMETRY
+    if (motor_load_counter) { motor_load_counter--; }
+    else if (sys.state & (STATE_CYCLE | STATE_JOG))  // homing reads the drivers itself
+    {
+      motor_load_counter = MOTOR_LOAD_POLL_TICKS-1;
+      carvin_motor_load_proc();
+    }
+  #endif
+
+  cli();
+  TIMSK5 |= (1 << OCIE5A);
+}
+
+#ifdef ENABLE_MOTOR_LOAD_TELEMETRY
+// timer5, with interrupts on. takes the readings requested by the last call and requests the next
+// ones, so the spi transfers run in the background between two calls. a reading only counts once the
+// axis has been stepping at least a full step per read for a while. stallGuard2 isn't valid slower,
+// or while the motor is still accelerating. axes whose driver didn't verify at boot are never
+// measured, a dead driver may read as a stall
+static void carvin_motor_load_proc()
+{
+  int32_t position[N_AXIS];
+  int32_t steps;
+  uint16_t sg;
+  uint8_t idx;
+
+  cli();
+  memcpy(position, sys_position, sizeof(sys_position));
+  sei();
+
+  for (idx=0; idx<N_AXIS; idx++)
+  {
+    steps = labs(position[idx] - motor_load_position[idx]);
+    motor_load_position[idx] = position[idx];
+    if ((steps < tmc26x_get_microsteps(idx)) || bit_isfalse(tmc26x_ready_mask, bit(idx)))
+    {
+      motor_load_moving[idx] = 0;
+      motor_load_filtered[idx] = (MOTOR_LOAD_SG_MAX << 4);  // not measured. report no load
+      continue;
+    }
+    if (motor_load_moving[idx] < MOTOR_LOAD_BLANK_POLLS)
+    {
+      motor_load_moving[idx]++;
+      continue;
+    }
+
+    sg = tmc26xStallGuardReading(idx);
+    motor_load_filtered[idx] += (int16_t)((sg << 4) - motor_load_filtered[idx]) >> MOTOR_LOAD_FILTER_SHIFT;
+
+    if (motor_load_margin && !motor_stall_report && ((motor_load_filtered[idx] >> 4) < motor_load_margin))
+    {
+      // serial output is main program only. the report goes out with the next realtime check
+      motor_stall_sg = motor_load_filtered[idx] >> 4;
+      motor_stall_report = idx+1;
+      if (motor_load_action)
+      {
+        mc_reset();  // stop now, like a hard limit
+        system_set_exec_alarm(EXEC_ALARM_MOTOR_STALL);
+      }
+      else
+      {
+        system_set_exec_state_flag(EXEC_FEED_HOLD);
+      }
+    }
+  }
+
+  tmc26x_request_status(READOUT_VALUE_SG2);
+}
+#endif
+
+#ifdef ENABLE_MOTOR_LOAD_TELEMETRY
+// copies the filtered stallGuard2 reading of each axis. 1023 = no load, 0 = stall
+void carvin_get_motor_load(uint16_t *sg)
+{
+  uint8_t idx;
+  uint8_t sreg = SREG;
+  cli();
+  for (idx=0; idx<N_AXIS; idx++) { sg[idx] = motor_load_filtered[idx] >> 4; }
+  SREG = sreg;
+}
+
+// prints the motor stall flagged by the timer5 isr, if any. called by main program
+void carvin_report_motor_stall()
+{
+  if (motor_stall_report)
+  {
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t axis = motor_stall_report-1;
+    uint16_t sg = motor_stall_sg;
+    SREG = sreg;
+    printPgmString(PSTR("[MotorStall:"));
+    serial_write("XYZ"[axis]);
+    serial_write(',');
+    print_uint32_base10(sg);
+    report_util_feedback_line_feed();
+    motor_stall_report = 0;  // armed again
+  }
+}
+
+// load the motor load stall margin ($805) and action ($806). called at startup and by carvin_settings_proc()
+void carvin_motor_load_init()
+{
+  float margin = 0.0;
+  float action = 0.0;
+  ps_settings_get_value( PS_SETTING_SG_LOAD_ALARM, &margin );
+  ps_settings_get_value( PS_SETTING_SG_LOAD_ACTION, &action );
+  uint8_t sreg = SREG;
+  cli();
+  motor_load_margin = (uint16_t)margin;
+  motor_load_action = (uint8_t)action;
+  SREG = sreg;
+}
+#endif
+
+// returns the timer5 tick count
+// the 16 bit count is not read atomically by the CPU, so keep the ISR out while copying it
+uint16_t carvin_get_tick_count()
+{
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t ticks = carvin_tick_count;
+  SREG = sreg;
+  return ticks;
+}
+
+// prints the spindle over current trip flagged by the timer5 isr, if any. called by main program
+void carvin_report_overcurrent()
+{
+  if (overcurrent_report)
+  {
+    uint8_t sreg = SREG;
+    cli();
+    float amps = overcurrent_amps;
+    overcurrent_report = 0;
+    SREG = sreg;
+    printPgmString(PSTR("[OverCurrent:"));
+    printFloat(amps, 2);
+    report_util_feedback_line_feed();
+  }
+}
+
+// returns the timer5 tick count extended with the timer counter, for a 16 usec time base
+// safe to call from an isr. a compare match that's waiting on the isr is counted as a tick
+uint32_t carvin_get_timer_count()
+{
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t ticks = carvin_tick_count;
+  uint16_t count = TCNT5;
+  if (TIFR5 & (1 << OCF5A))
+  {
+    ticks++;
+    count = TCNT5;  // re-read, the counter may have just cleared
+  }
+  SREG = sreg;
+  return ((uint32_t)ticks*(CARVIN_TIMING_CTC+1) + count);
+}
+
+// returns the time in usec between two carvin_get_timer_count() values. handles one wrap
+uint32_t carvin_get_elapsed_us(uint32_t start, uint32_t end)
+{
+  if (end < start) { end += CARVIN_TIMER_COUNT_WRAP; }
+  return ((end - start)*CARVIN_TIMER_USEC_PER_COUNT);
+}
+
+// main program. recomputes the values derived from the product settings once per change, so
+// the timer5 isr never touches the settings or does float math on them
+void carvin_settings_proc()
+{
+  uint8_t generation = ps_settings_get_generation();
+  if (generation != settings_generation)
+  {
+    settings_generation = generation;
+    spindle_current_load_threshold();
+    carvin_auto_report_init();
+    #ifdef ENABLE_MOTOR_LOAD_TELEMETRY
+      carvin_motor_load_init();
+    #endif
+  }
+}
+
+// load the status auto report interval from $801 (ms) and convert it to timer5 ticks
+// zero or less disables it. called at startup and by carvin_settings_proc()
+void carvin_auto_report_init()
+{
+  float interval_ms = 0.0;
+  uint16_t ticks = 0;
+
+  ps_settings_get_value( PS_SETTING_AUTO_REPORT_INTERVAL, &interval_ms );
+  if (interval_ms > 0.0)
+  {
+    if (interval_ms < AUTO_REPORT_MIN_INTERVAL) { interval_ms = AUTO_REPORT_MIN_INTERVAL; }
+    float interval_ticks = interval_ms*(CARVIN_TICKS_PER_SECOND/1000.0);
+    if (interval_ticks > 0xFFFF) { ticks = 0xFFFF; }
+    else { ticks = (uint16_t)interval_ticks; }
+  }
+
+  uint8_t sreg = SREG;
+  cli();
+  auto_report_interval = ticks;
+  auto_report_counter = ticks;
+  auto_report_state = sys.state;
+  SREG = sreg;
 }
 
 // init or reset the led values
@@ -269,6 +559,7 @@ uint8_t get_hardware_rev()
  */
 void reset_cpu()
 {
+  eeprom_flush();  // don't lose queued settings writes
   wdt_enable(WDTO_15MS);
   while(1)
   {
@@ -39,11 +39,18 @@
 #define BUTTON_LED_RISE_TIME 3  // the time it takes to fade on
 
 #define CARVIN_TIMING_CTC 120  // timer interrupt compare value...set this for a roughly 512 hz interrupt, so we can fade 256 levels in 1/2 second
+#define CARVIN_TICKS_PER_SECOND (F_CPU/256.0/(CARVIN_TIMING_CTC+1))  // actual timer5 interrupt rate (~516 Hz)
 
 #define CONTROL_DEBOUNCE_COUNT 8 // this is count down by timer5
 
+#define AUTO_REPORT_MIN_INTERVAL 20  // ms. shortest status auto report interval, keeps the serial TX from saturating
+// states reported at a fixed cadence. other states are only reported when entered
+#define AUTO_REPORT_MOTION_STATES (STATE_HOMING | STATE_CYCLE | STATE_HOLD | STATE_JOG | STATE_SAFETY_DOOR)
+
 extern int control_button_counter;  // Used to debounce the control button.
 
+extern volatile uint16_t carvin_tick_count;  // free running count of timer5 interrupts. Wraps every ~2 minutes.
+
 int use_sleep_feature;
 int hardware_rev;
 
@@ -69,6 +76,29 @@ extern void throb_pwm(struct pwm_analog * pwm, uint8_t min_throb, uint8_t durati
 
 extern uint8_t get_hardware_rev();  // return the hardware rev number
 
+extern uint16_t carvin_get_tick_count();  // atomic read of the timer5 tick count for the main program
+
+#define CARVIN_TIMER_USEC_PER_COUNT (256000000UL/F_CPU)  // timer5 counter resolution (16 usec)
+#define CARVIN_TIMER_COUNT_WRAP (65536UL*(CARVIN_TIMING_CTC+1))  // carvin_get_timer_count() wraps here (~2 minutes)
+
+extern uint32_t carvin_get_timer_count();  // fine time base. timer5 ticks and counter, in timer counts
+extern uint32_t carvin_get_elapsed_us(uint32_t start, uint32_t end);  // usec between two timer counts
+
+extern uint16_t carvin_boot_time_ms;  // msec from power up to the first banner, reported by $I
+extern void carvin_boot_timer_start();  // first thing in main. times the boot until carvin_init
+extern void carvin_record_boot_time();  // before the banner. latches carvin_boot_time_ms once
+
+extern void carvin_report_overcurrent();  // print a spindle over current trip flagged by timer5
+
+#ifdef ENABLE_MOTOR_LOAD_TELEMETRY
+  extern void carvin_motor_load_init();  // load the stall margin and action settings ($805, $806)
+  extern void carvin_get_motor_load(uint16_t *sg);  // filtered StallGuard2 reading of each axis
+  extern void carvin_report_motor_stall();  // print a motor stall flagged by timer5
+#endif
+
+extern void carvin_settings_proc();  // main program. apply product setting changes
+extern void carvin_auto_report_init();  // load the status auto report interval setting ($801)
+
 extern void reset_cpu();   // software full reset of the CPU
 
 extern void print_switch_states();
@@ -36,6 +36,14 @@
 // Serial baud rate
 #define BAUD_RATE 115200
 
+// Enables the '$U=<baud>' command to switch the serial link to a higher baud rate at runtime. The 'ok'
+// is sent at the current rate. Grbl then switches and waits for the host to confirm the link by sending
+// a '?' status report request at the new rate, which is answered as usual. If none arrives in time, or
+// upon any reset, Grbl falls back to BAUD_RATE. Supported rates are 115200, 250000, 500000, and 1000000,
+// which the 2560 USART generates without error at 16MHz with the baud doubler, except for 115200.
+#define ENABLE_BAUD_RATE_COMMAND // Default enabled. Comment to disable.
+#define BAUD_RATE_HANDSHAKE_TIMEOUT 1000 // Integer (milliseconds) Time for host to confirm a new rate.
+
 // Default cpu mappings. Grbl officially supports the Arduino Uno only. Other processor types
 // may exist from user-supplied templates or directly user-defined in cpu_map.h
 #define CPU_MAP_CARVIN
@@ -123,6 +131,21 @@
 // define to force Grbl to always set the machine origin at the homed location despite switch orientation.
 // #define HOMING_FORCE_SET_ORIGIN // Uncomment to enable.
 
+// Carvin only. Homes against the mechanical end of travel by sensing the motor stall with the TMC26x
+// StallGuard2 load measurement, in a single pass at the homing seek rate, instead of seeking the
+// limit switches and locating them again at the slower homing feed rate. A homing cycle uses it only
+// when all of its axes have a nonzero stall threshold setting ($802-$804), so it does nothing until
+// those are tuned for the machine. The limit switches still stop an axis, if they trigger first.
+// NOTE: The stall position replaces the switch position, so the pull-off setting may need retuning.
+#define HOMING_STALLGUARD // Default enabled. Comment to disable.
+
+// Carvin only. Reads the TMC26x StallGuard2 load measurement of each axis in the background while in
+// motion, at about 130Hz, and keeps a filtered reading per axis. Readings only count while an axis
+// steps fast enough for them to be valid. Setting bit 4 (value 16) of the $10 status report mask adds
+// the |SG:x,y,z field, 1023 being no load and 0 a stall. With a stall margin set ($805), a moving axis
+// whose reading drops under it triggers a feed hold, or an alarm with $806=1, before steps are lost.
+#define ENABLE_MOTOR_LOAD_TELEMETRY // Default enabled. Comment to disable.
+
 // Number of blocks Grbl executes upon startup. These blocks are stored in EEPROM, where the size
 // and addresses are defined in settings.h. With the current settings, up to 2 startup blocks may
 // be stored and executed in order. These startup blocks would typically be used to set the g-code
@@ -287,6 +310,14 @@
 #define REPORT_WCO_REFRESH_BUSY_COUNT 30  // (2-255)
 #define REPORT_WCO_REFRESH_IDLE_COUNT 10  // (2-255) Must be less than or equal to the busy count
 
+// Enables the compact status report, selected by setting bit 2 (value 4) of the $10 status report
+// mask. Instead of the full report, only the fields that changed since the last report are sent,
+// as integers: positions in steps, rates in mm/min and rpm. No float formatting is done. Bit 3
+// (value 8) additionally sends the fields as a base64 encoded binary frame. Every so many reports,
+// all fields are sent, so a GUI connecting in the middle of a job syncs up. See report.h.
+#define ENABLE_COMPACT_STATUS_REPORT // Default enabled. Comment to disable.
+#define REPORT_COMPACT_REFRESH_COUNT 50  // (1-255) Reports between full refreshes.
+
 // The temporal resolution of the acceleration management subsystem. A higher number gives smoother
 // acceleration, particularly noticeable on machines that run at very high feedrates, but may negatively
 // impact performance. The correct value for this parameter is machine dependent, so it's advised to
@@ -451,8 +482,58 @@
 // 115200 baud will take 5 msec to transmit a typical 55 character report. Worst case reports are
 // around 90-100 characters. As long as the serial TX buffer doesn't get continually maxed, Grbl
 // will continue operating efficiently. Size the TX buffer around the size of a worst-case report.
-// #define RX_BUFFER_SIZE 128 // (1-254) Uncomment to override defaults in serial.h
-// #define TX_BUFFER_SIZE 100 // (1-254)
+// NOTE: Status report 'Bf:' field reports the full available RX buffer count, up to RX_BUFFER_SIZE.
+// #define RX_BUFFER_SIZE 1024 // (1-4095) Uncomment to override defaults in serial.h
+// #define TX_BUFFER_SIZE 256 // (1-4095)
+// #define TX_LINE_BUFFER_SIZE 128 // (1-255) Must be less than TX_BUFFER_SIZE.
+
+// Enables '%' program delimiters. A '%' line starts program mode and the next one ends it, as a
+// g-code file is typically framed. While in program mode, Grbl assumes a continuous stream and holds
+// off the main loop auto-cycle start, when the program begins or resumes after a command that emptied
+// the planner buffer, until enough blocks are queued for the planner to look ahead over or the stream
+// pauses for the set delay. This removes the stop-and-go of executing the first few short blocks of
+// a burst before the following blocks arrive. A full planner buffer always starts the cycle.
+// NOTE: Outside of program mode, i.e. interactive commands, motions start immediately as usual.
+#define ENABLE_PROGRAM_MODE // Default enabled. Comment to disable.
+#define PROGRAM_MODE_START_BLOCKS 8 // Integer (1-BLOCK_BUFFER_SIZE-1) Queued blocks to start the cycle.
+#define PROGRAM_MODE_START_DELAY 0.1 // Float (seconds) Stream pause that starts the cycle anyway.
+
+// Enables queuing spindle speed changes, spindle stop, and coolant changes with the planner blocks,
+// rather than draining the planner buffer to a full stop before applying them. A queued change is
+// applied by the stepper ISR when the next planned block starts executing, just as spindle PWM is
+// already updated per block, or as soon as motion completes, if no block follows it. Programs that
+// change S mid-toolpath, like adaptive feed and speed jobs, keep moving through the change.
+// NOTE: Starting or reversing the spindle still syncs, so it comes up to speed before cutting.
+#define ENABLE_QUEUED_ACCESSORY_STATE // Default enabled. Comment to disable.
+
+// Enables a g-code parser fast path for blocks with only axis words that continue the active G0 or
+// G1 motion mode, such as 'X1.2Y3.4'. These make up the bulk of dense 3D toolpaths. The fast path
+// skips the parser block initialization and modal error-checking and plans the motion directly. It
+// produces exactly the same planner targets and parser state as the full parser. Any other block,
+// or a block with an error, is executed by the full parser.
+#define ENABLE_GCODE_MODAL_FAST_PATH // Default enabled. Comment to disable.
+
+// Enables the sequenced stream mode, toggled by the '$A' command. While active, streamed lines may
+// be framed with a sequence number and checksum. Grbl acknowledges many executed lines at once with
+// a cumulative 'ok:<seq>' and requests a resend of corrupted or lost lines, rather than sending an
+// 'ok' per line. This cuts the TX traffic and sender latency per line and makes high baud rates
+// safe. Unframed lines are acknowledged as usual. See sequenced_stream.c for the protocol.
+#define ENABLE_SEQUENCED_STREAM // Default enabled. Comment to disable.
+#define SEQUENCED_STREAM_ACK_LINES 16 // (1-127) Executed lines to acknowledge at once, at most.
+
+// Enables the compact binary motion streaming mode, toggled by the '$B' command. While active, each
+// streamed line is a base64-encoded frame carrying fixed-point G0/G1 targets and feed rate, which
+// are passed directly to mc_line() without g-code parsing. This cuts the serial bandwidth per move
+// roughly in half and skips the float parser. All '$' and realtime commands remain available. See
+// binary_motion.c for the frame format.
+#define ENABLE_BINARY_MOTION_STREAM // Default enabled. Comment to disable.
+
+// Enables realtime command latency statistics. Each realtime command is timestamped upon receipt
+// by the serial RX ISR and again when the main program services it in protocol_exec_rt_system().
+// The count and maximum latency per command type and a histogram of all latencies are printed by
+// the '$T' command and cleared by '$T=0'. They are kept through resets. The Carvin Timer5 is the
+// time base, with a 16 usec resolution. Costs a few usec per realtime command.
+#define ENABLE_RT_LATENCY_STATS // Default enabled. Comment to disable.
 
 // A simple software debouncing feature for hard limit switches. When enabled, the interrupt 
 // monitoring the hard limit switch pins will enable the Arduino's watchdog timer to re-check 
@@ -517,6 +598,9 @@
 // cause active stepping to lose position and serial receive data to be lost. This configuration
 // option forces the planner buffer to completely empty whenever the EEPROM is written to prevent
 // any chance of lost steps.
+// NOTE: EEPROM writes are now queued and programmed in the background by the EEPROM ready
+// interrupt (see eeprom.c), which never disables interrupts for more than a few cycles. The sync is
+// no longer needed, so coordinate set g-code commands may be streamed during a job.
 // However, this doesn't prevent issues with lost serial RX data during an EEPROM write, especially
 // if a GUI is premptively filling up the serial RX buffer simultaneously. It's highly advised for
 // GUIs to flag these gcodes (G10,G28.1,G30.1) to always wait for an 'ok' after a block containing
@@ -524,7 +608,14 @@
 // NOTE: Most EEPROM write commands are implicitly blocked during a job (all '$' commands). However,
 // coordinate set g-code commands (G10,G28/30.1) are not, since they are part of an active streaming
 // job. At this time, this option only forces a planner buffer sync with these g-code commands.
-#define FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE // Default enabled. Comment to disable.
+// #define FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE // Default disabled. Uncomment to enable.
+
+// Stores the coordinate offsets and product settings as records appended to a wear-leveled journal
+// in the upper EEPROM (see journal.c), instead of rewriting them at fixed addresses. A G10 or '$8xx'
+// change then writes a single 16-byte record, and wear spreads over the whole journal region. Values
+// not yet in the journal are still read from their fixed addresses, so existing machines keep them.
+// NOTE: Requires the 4KB EEPROM of the ATmega2560. Firmware without the journal reads stale values.
+#define ENABLE_EEPROM_JOURNAL // Default enabled. Comment to disable.
 
 // In Grbl v0.9 and prior, there is an old outstanding bug where the `WPos:` work position reported
 // may not correlate to what is executing, because `WPos:` is based on the g-code parser state, which
@@ -532,7 +623,11 @@
 // motion whenever there is a command that alters the work coordinate offsets `G10,G43.1,G92,G54-59`.
 // This is the simplest way to ensure `WPos:` is always correct. Fortunately, it's exceedingly rare
 // that any of these commands are used need continuous motions through them.
-#define FORCE_BUFFER_SYNC_DURING_WCO_CHANGE // Default enabled. Comment to disable.
+// NOTE: When disabled, each planner block is tagged with the offset it was planned with and status
+// reports use the offset of the executing block instead, so `WPos:` and `WCO:` stay correct while
+// G54-59, G92, and G43.1 changes are queued mid-stream. Multi-part fixture jobs then don't stop at
+// every coordinate system change. G10 L2/L20 still syncs, if EEPROM writes force a sync above.
+// #define FORCE_BUFFER_SYNC_DURING_WCO_CHANGE // Default disabled. Uncomment to enable.
 
 // By default, Grbl disables feed rate overrides for all G38.x probe cycle commands. Although this
 // may be different than some pro-class machine control, it's arguable that it should be this way. 
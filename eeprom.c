@@ -23,6 +23,7 @@
 ****************************************************************************/
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include "eeprom.h"
 
 /* These EEPROM bits have different names on different devices. */
 #ifndef EEPE
@@ -37,9 +38,45 @@
 /* Define to reduce code size. */
 #define EEPROM_IGNORE_SELFPROG //!< Remove SPM flag polling.
 
+/* Write-behind queue of bytes waiting to be programmed, drained by the EEPROM ready
+ * interrupt. Reads check the queue first, so they always return the latest value written. */
+static unsigned int eeprom_queue_addr[EEPROM_WRITE_QUEUE_SIZE];
+static unsigned char eeprom_queue_data[EEPROM_WRITE_QUEUE_SIZE];
+static volatile unsigned char eeprom_queue_head = 0;
+static volatile unsigned char eeprom_queue_tail = 0;
+
+static unsigned char eeprom_queue_next( unsigned char index )
+{
+	if( ++index == EEPROM_WRITE_QUEUE_SIZE ) { index = 0; }
+	return index;
+}
+
+/*! \brief  Find the newest queued value of an EEPROM address.
+ *
+ *  \note  Must be called with interrupts disabled.
+ *
+ *  \return  Nonzero, if the address is queued and value was set.
+ */
+static unsigned char eeprom_queue_find( unsigned int addr, unsigned char *value )
+{
+	unsigned char index = eeprom_queue_head;
+	while( index != eeprom_queue_tail ) {
+		if( index == 0 ) { index = EEPROM_WRITE_QUEUE_SIZE; }
+		index--;
+		if( eeprom_queue_addr[index] == addr ) {
+			*value = eeprom_queue_data[index];
+			return 1;
+		}
+	}
+	return 0;
+}
+
 /*! \brief  Read byte from EEPROM.
  *
- *  This function reads one byte from a given EEPROM address.
+ *  This function reads one byte from a given EEPROM address. A value
+ *  still waiting in the write queue is returned without reading the EEPROM.
+ *  Interrupts are only disabled once the EEPROM is idle, so a write in
+ *  progress doesn't hold off the stepper and serial interrupts.
  *
  *  \note  The CPU is halted for 4 clock cycles during EEPROM read.
  *
@@ -48,43 +85,48 @@
  */
 unsigned char eeprom_get_char( unsigned int addr )
 {
-	do {} while( EECR & (1<<EEPE) ); // Wait for completion of previous write.
-	EEAR = addr; // Set EEPROM address register.
-	EECR = (1<<EERE); // Start EEPROM read operation.
-	return EEDR; // Return the byte read from EEPROM.
+	unsigned char value;
+	unsigned char sreg = SREG;
+	for(;;) {
+		cli();
+		if( eeprom_queue_find( addr, &value ) ) { break; }
+		if( !(EECR & (1<<EEPE)) ) {
+			EEAR = addr; // Set EEPROM address register.
+			EECR |= (1<<EERE); // Start EEPROM read operation. Keeps the ready interrupt enable.
+			value = EEDR;
+			break;
+		}
+		SREG = sreg; // Wait for completion of previous write with interrupts restored.
+	}
+	SREG = sreg;
+	return value;
 }
 
-/*! \brief  Write byte to EEPROM.
+/*! \brief  Program byte to EEPROM.
  *
- *  This function writes one byte to a given EEPROM address.
+ *  This function programs one byte at a given EEPROM address.
  *  The differences between the existing byte and the new value is used
  *  to select the most efficient EEPROM programming mode.
  *
- *  \note  The CPU is halted for 2 clock cycles during EEPROM programming.
- *
- *  \note  When this function returns, the new EEPROM value is not available
- *         until the EEPROM programming time has passed. The EEPE bit in EECR
- *         should be polled to check whether the programming is finished.
+ *  \note  Must be called with interrupts disabled and the EEPROM idle.
  *
- *  \note  The EEPROM_GetChar() function checks the EEPE bit automatically.
+ *  \note  The CPU is halted for 2 clock cycles during EEPROM programming.
  *
  *  \param  addr  EEPROM address to write to.
  *  \param  new_value  New EEPROM value.
  */
-void eeprom_put_char( unsigned int addr, unsigned char new_value )
+static void eeprom_program_char( unsigned int addr, unsigned char new_value )
 {
 	char old_value; // Old EEPROM value.
 	char diff_mask; // Difference mask, i.e. old value XOR new value.
+	unsigned char ready_int = EECR & (1<<EERIE); // Ready interrupt enable, kept as is.
 
-	cli(); // Ensure atomic operation for the write operation.
-	
-	do {} while( EECR & (1<<EEPE) ); // Wait for completion of previous write.
 	#ifndef EEPROM_IGNORE_SELFPROG
 	do {} while( SPMCSR & (1<<SELFPRGEN) ); // Wait for completion of SPM.
 	#endif
-	
+
 	EEAR = addr; // Set EEPROM address register.
-	EECR = (1<<EERE); // Start EEPROM read operation.
+	EECR |= (1<<EERE); // Start EEPROM read operation.
 	old_value = EEDR; // Get old EEPROM value.
 	diff_mask = old_value ^ new_value; // Get bit differences.
 	
@@ -97,13 +139,13 @@ void eeprom_put_char( unsigned int addr, unsigned char new_value )
 			// Now we know that some bits need to be programmed to '0' also.
 			
 			EEDR = new_value; // Set EEPROM data register.
-			EECR = (1<<EEMPE) | // Set Master Write Enable bit...
+			EECR = ready_int | (1<<EEMPE) | // Set Master Write Enable bit...
 			       (0<<EEPM1) | (0<<EEPM0); // ...and Erase+Write mode.
 			EECR |= (1<<EEPE);  // Start Erase+Write operation.
 		} else {
 			// Now we know that all bits should be erased.
 
-			EECR = (1<<EEMPE) | // Set Master Write Enable bit...
+			EECR = ready_int | (1<<EEMPE) | // Set Master Write Enable bit...
 			       (1<<EEPM0);  // ...and Erase-only mode.
 			EECR |= (1<<EEPE);  // Start Erase-only operation.
 		}
@@ -115,13 +157,95 @@ void eeprom_put_char( unsigned int addr, unsigned char new_value )
 			// Now we know that _some_ bits need to the programmed to '0'.
 			
 			EEDR = new_value;   // Set EEPROM data register.
-			EECR = (1<<EEMPE) | // Set Master Write Enable bit...
+			EECR = ready_int | (1<<EEMPE) | // Set Master Write Enable bit...
 			       (1<<EEPM1);  // ...and Write-only mode.
 			EECR |= (1<<EEPE);  // Start Write-only operation.
 		}
 	}
-	
-	sei(); // Restore interrupt flag state.
+}
+
+/*! \brief  Program the oldest queued byte.
+ *
+ *  \note  Must be called with interrupts disabled, the EEPROM idle and the queue not empty.
+ */
+static void eeprom_queue_program( void )
+{
+	unsigned char tail = eeprom_queue_tail;
+	eeprom_program_char( eeprom_queue_addr[tail], eeprom_queue_data[tail] );
+	eeprom_queue_tail = eeprom_queue_next( tail );
+}
+
+/*! \brief  Drain the queue without the ready interrupt, when interrupts are disabled.
+ *
+ *  \param  empty  Nonzero to drain all of the queue, otherwise until one entry is free.
+ */
+static void eeprom_queue_drain( unsigned char empty )
+{
+	while( eeprom_queue_tail != eeprom_queue_head ) {
+		if( !empty && (eeprom_queue_next( eeprom_queue_head ) != eeprom_queue_tail) ) { return; }
+		do {} while( EECR & (1<<EEPE) ); // Wait for completion of previous write.
+		eeprom_queue_program();
+	}
+}
+
+/*! \brief  Write byte to EEPROM.
+ *
+ *  This function queues one byte to be written to a given EEPROM address
+ *  and returns right away. The EEPROM ready interrupt programs the queued
+ *  bytes in order in the background, so the 3.3 ms programming time of
+ *  each byte no longer stalls the CPU with interrupts disabled. Only waits,
+ *  with interrupts enabled, if the queue is full.
+ *
+ *  \note  Reads with eeprom_get_char() return the new value right away.
+ *
+ *  \param  addr  EEPROM address to write to.
+ *  \param  new_value  New EEPROM value.
+ */
+void eeprom_put_char( unsigned int addr, unsigned char new_value )
+{
+	unsigned char sreg = SREG;
+	unsigned char head = eeprom_queue_head;
+	unsigned char next_head = eeprom_queue_next( head );
+
+	if( next_head == eeprom_queue_tail ) {
+		if( sreg & (1<<SREG_I) ) {
+			do {} while( next_head == eeprom_queue_tail ); // Ready interrupt is draining the queue.
+		} else {
+			eeprom_queue_drain( 0 ); // No interrupts. Program the oldest byte here.
+		}
+	}
+
+	eeprom_queue_addr[head] = addr;
+	eeprom_queue_data[head] = new_value;
+	cli();
+	eeprom_queue_head = next_head;
+	EECR |= (1<<EERIE); // Enable ready interrupt to make sure the queue is draining.
+	SREG = sreg;
+}
+
+/*! \brief  Wait until all queued bytes are programmed.
+ *
+ *  Used before a hard reset, which would lose them. Safe to call with
+ *  interrupts disabled.
+ */
+void eeprom_flush( void )
+{
+	unsigned char sreg = SREG;
+	cli();
+	eeprom_queue_drain( 1 );
+	do {} while( EECR & (1<<EEPE) ); // Wait for completion of the last write.
+	SREG = sreg;
+}
+
+/*! \brief  EEPROM ready interrupt. Programs the next queued byte, if any.
+ */
+ISR(EE_READY_vect)
+{
+	if( eeprom_queue_tail == eeprom_queue_head ) {
+		EECR &= ~(1<<EERIE); // Queue empty. Stop the ready interrupt.
+	} else {
+		eeprom_queue_program();
+	}
 }
 
 // Extensions added as part of Grbl 
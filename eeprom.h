@@ -21,8 +21,15 @@
 #ifndef eeprom_h
 #define eeprom_h
 
+// Number of bytes the EEPROM write queue holds. Writes only wait when it's full. Sized for the
+// global settings struct, the largest single write. (2-255)
+#ifndef EEPROM_WRITE_QUEUE_SIZE
+  #define EEPROM_WRITE_QUEUE_SIZE 128
+#endif
+
 unsigned char eeprom_get_char(unsigned int addr);
 void eeprom_put_char(unsigned int addr, unsigned char new_value);
+void eeprom_flush();
 void memcpy_to_eeprom_with_checksum(unsigned int destination, char *source, unsigned int size);
 int memcpy_from_eeprom_with_checksum(char *destination, unsigned int source, unsigned int size);
 
@@ -47,6 +47,9 @@ void gc_init()
   if (!(settings_read_coord_data(gc_state.modal.coord_select,gc_state.coord_system))) {
     report_status_message(STATUS_SETTING_READ_FAIL);
   }
+  #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+    gc_get_wco(sys_wco);
+  #endif
 }
 
 
@@ -58,6 +61,105 @@ void gc_sync_position()
 }
 
 
+// Computes the work coordinate offset of the parser state. Called by the planner to tag blocks
+// and when the executing offset is synced to the parser state.
+void gc_get_wco(float *wco)
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    wco[idx] = gc_state.coord_system[idx]+gc_state.coord_offset[idx];
+    if (idx == TOOL_LENGTH_OFFSET_AXIS) { wco[idx] += gc_state.tool_length_offset; }
+  }
+}
+
+
+#ifdef ENABLE_QUEUED_ACCESSORY_STATE
+// Queues an accessory state change to be applied when the next planned block starts, rather than
+// syncing the planner buffer. Returns false, if a sync is still required. With an empty planner,
+// there is no motion to queue behind and the sync is immediate anyhow.
+// NOTE: Laser mode manages its own spindle syncs with motion. Those are left as is.
+static uint8_t gc_queue_accessory_update(uint8_t update_flag)
+{
+  if (sys.state == STATE_CHECK_MODE) { return(false); }
+  if ((update_flag & PL_ACCESSORY_UPDATE_SPINDLE) && bit_istrue(settings.flags,BITFLAG_LASER_MODE)) { return(false); }
+  if (plan_get_current_block() == NULL) { return(false); }
+  sys.accessory_update |= update_flag;
+  return(true);
+}
+#else
+  #define gc_queue_accessory_update(update_flag) false
+#endif
+
+
+#ifdef ENABLE_GCODE_MODAL_FAST_PATH
+// Fast path for the most common streamed block: axis words only, continuing a modal G0 or G1.
+// Parses and plans the motion without the full parser block setup and error-checking cascade.
+// Returns false, with no state altered, if the line is not eligible. The full parser must then
+// execute the line, which also produces any applicable error.
+// NOTE: Must produce exactly the same planner input and parser state as gc_execute_line().
+// Computation order of the target conversions mirrors STEP 3 so the results are bit-identical.
+static uint8_t gc_execute_modal_motion(char *line)
+{
+  // Only G0/G1 in G94 mode with a defined feed rate, when G1. Laser mode requires the full
+  // parser to manage laser power state changes.
+  if (gc_state.modal.motion == MOTION_MODE_LINEAR) {
+    if (gc_state.feed_rate == 0.0) { return(false); }
+  } else if (gc_state.modal.motion != MOTION_MODE_SEEK) { return(false); }
+  if (gc_state.modal.feed_rate != FEED_RATE_MODE_UNITS_PER_MIN) { return(false); }
+  if (bit_istrue(settings.flags,BITFLAG_LASER_MODE)) { return(false); }
+
+  float target[N_AXIS];
+  uint8_t axis_words = 0;
+  uint8_t char_counter = 0;
+  uint8_t idx;
+  while (line[char_counter] != 0) {
+    switch(line[char_counter]) {
+      case 'X': idx = X_AXIS; break;
+      case 'Y': idx = Y_AXIS; break;
+      case 'Z': idx = Z_AXIS; break;
+      default: return(false);
+    }
+    if (bit_istrue(axis_words,bit(idx))) { return(false); } // Repeated word. Let parser report it.
+    char_counter++;
+    if (!read_float(line, &char_counter, &target[idx])) { return(false); }
+    axis_words |= bit(idx);
+  }
+  if (!axis_words) { return(false); }
+
+  // Eligible block. Convert axis words to absolute machine targets.
+  for (idx=0; idx<N_AXIS; idx++) {
+    if ( bit_isfalse(axis_words,bit(idx)) ) {
+      target[idx] = gc_state.position[idx];
+    } else {
+      if (gc_state.modal.units == UNITS_MODE_INCHES) { target[idx] *= MM_PER_INCH; }
+      if (gc_state.modal.distance == DISTANCE_MODE_ABSOLUTE) {
+        target[idx] += gc_state.coord_system[idx] + gc_state.coord_offset[idx];
+        if (idx == TOOL_LENGTH_OFFSET_AXIS) { target[idx] += gc_state.tool_length_offset; }
+      } else {
+        target[idx] += gc_state.position[idx];
+      }
+    }
+  }
+
+  // Update parser state as the full parser would for a block without N and T words.
+  gc_state.line_number = 0;
+  gc_state.tool = 0;
+
+  plan_line_data_t plan_data;
+  plan_line_data_t *pl_data = &plan_data;
+  memset(pl_data,0,sizeof(plan_line_data_t));
+  pl_data->feed_rate = gc_state.feed_rate;
+  pl_data->spindle_speed = gc_state.spindle_speed;
+  pl_data->condition = (gc_state.modal.spindle | gc_state.modal.coolant);
+  if (gc_state.modal.motion == MOTION_MODE_SEEK) { pl_data->condition |= PL_COND_FLAG_RAPID_MOTION; }
+
+  mc_line(target, pl_data);
+  memcpy(gc_state.position, target, sizeof(target));
+  return(true);
+}
+#endif
+
+
 // Executes one line of 0-terminated G-Code. The line is assumed to contain only uppercase
 // characters and signed floating point values (no whitespace). Comments and block delete
 // characters have been removed. In this function, all units and positions are converted and
@@ -72,6 +174,11 @@ uint8_t gc_execute_line(char *line)
      values struct, word tracking variables, and a non-modal commands tracker for the new
      block. This struct contains all of the necessary information to execute the block. */
 
+  #ifdef ENABLE_GCODE_MODAL_FAST_PATH
+    // Jog lines begin with '$' and are never eligible.
+    if (gc_execute_modal_motion(line)) { return(STATUS_OK); }
+  #endif
+
   memset(&gc_block, 0, sizeof(parser_block_t)); // Initialize the parser block struct.
   memcpy(&gc_block.modal,&gc_state.modal,sizeof(gc_modal_t)); // Copy current modes
 
@@ -108,6 +215,7 @@ uint8_t gc_execute_line(char *line)
   uint8_t word_bit; // Bit-value for assigning tracking variables
   uint8_t char_counter;
   char letter;
+  number_t number;
   float value;
   uint8_t int_value = 0;
   uint16_t mantissa = 0;
@@ -120,18 +228,22 @@ uint8_t gc_execute_line(char *line)
     letter = line[char_counter];
     if((letter < 'A') || (letter > 'Z')) { FAIL(STATUS_EXPECTED_COMMAND_LETTER); } // [Expected word letter]
     char_counter++;
-    if (!read_float(line, &char_counter, &value)) { FAIL(STATUS_BAD_NUMBER_FORMAT); } // [Expected word value]
+    if (!read_number(line, &char_counter, &number)) { FAIL(STATUS_BAD_NUMBER_FORMAT); } // [Expected word value]
 
-    // Convert values to smaller uint8 significand and mantissa values for parsing this word.
+    // Smaller uint8 significand and mantissa values for parsing this word, captured by read_number().
     // NOTE: Mantissa is multiplied by 100 to catch non-integer command values. This is more
     // accurate than the NIST gcode requirement of x10 when used for commands, but not quite
     // accurate enough for value words that require integers to within 0.0001. This should be
     // a good enough comprimise and catch most all non-integer errors. To make it compliant,
     // we would simply need to change the mantissa to int16, but this add compiled flash space.
     // Maybe update this later.
-    int_value = trunc(value);
-    mantissa =  round(100*(value - int_value)); // Compute mantissa for Gxx.x commands.
-    // NOTE: Rounding must be used to catch small floating point errors.
+    int_value = number.int_value;
+    mantissa = number.mantissa; // Mantissa for Gxx.x commands. Rounded on the third decimal.
+    // NOTE: int_value and mantissa are unsigned. Words parsed from them can't be negative.
+    // F, N, P, T and S are checked with the other value words below.
+    if (number.isnegative) {
+      if ((letter == 'G') || (letter == 'M') || (letter == 'L')) { FAIL(STATUS_NEGATIVE_VALUE); } // [Word value cannot be negative]
+    }
 
     // Check if the g-code word is supported or errors due to modal group violations or has
     // been repeated in the g-code block. If ok, update the command or record its value.
@@ -294,6 +406,8 @@ uint8_t gc_execute_line(char *line)
         /* Non-Command Words: This initial parsing phase only checks for repeats of the remaining
            legal g-code words and stores their value. Error-checking is performed later since some
            words (I,J,K,L,P,R) have multiple connotations and/or depend on the issued commands. */
+        // NOTE: Command words above never need the floating point value. Convert only here.
+        value = number_to_float(&number);
         switch(letter){
           // case 'A': // Not supported
           // case 'B': // Not supported
@@ -908,7 +1022,9 @@ uint8_t gc_execute_line(char *line)
   if ((gc_state.spindle_speed != gc_block.values.s) || bit_istrue(gc_parser_flags,GC_PARSER_LASER_FORCE_SYNC)) {
     if (gc_state.modal.spindle != SPINDLE_DISABLE) { 
       #ifdef VARIABLE_SPINDLE
-        if (bit_isfalse(gc_parser_flags,GC_PARSER_LASER_ISMOTION)) {
+        // NOTE: A speed change of a running spindle may be queued and applied by the stepper with
+        // the next block, like laser motions do, rather than synced.
+        if (bit_isfalse(gc_parser_flags,GC_PARSER_LASER_ISMOTION) && !gc_queue_accessory_update(PL_ACCESSORY_UPDATE_SPINDLE)) {
           if (bit_istrue(gc_parser_flags,GC_PARSER_LASER_DISABLE)) {
              spindle_sync(gc_state.modal.spindle, 0.0);
           } else { spindle_sync(gc_state.modal.spindle, gc_block.values.s); }
@@ -932,9 +1048,17 @@ uint8_t gc_execute_line(char *line)
   // [7. Spindle control ]:
   if (gc_state.modal.spindle != gc_block.modal.spindle) {
     // Update spindle control and apply spindle speed when enabling it in this block.
-    // NOTE: All spindle state changes are synced, even in laser mode. Also, pl_data,
-    // rather than gc_state, is used to manage laser state for non-laser motions.
-    spindle_sync(gc_block.modal.spindle, pl_data->spindle_speed);
+    // NOTE: All spindle state changes are synced, even in laser mode, except a spindle stop that
+    // may be queued with the planner. Starting or reversing syncs to let the spindle come up to
+    // speed before motion resumes. Also, pl_data, rather than gc_state, is used to manage laser
+    // state for non-laser motions.
+    #ifdef VARIABLE_SPINDLE
+      if ((gc_block.modal.spindle != SPINDLE_DISABLE) || !gc_queue_accessory_update(PL_ACCESSORY_UPDATE_SPINDLE)) {
+        spindle_sync(gc_block.modal.spindle, pl_data->spindle_speed);
+      }
+    #else
+      spindle_sync(gc_block.modal.spindle, pl_data->spindle_speed);
+    #endif
     gc_state.modal.spindle = gc_block.modal.spindle;
   }
   pl_data->condition |= gc_state.modal.spindle; // Set condition flag for planner use.
@@ -943,7 +1067,7 @@ uint8_t gc_execute_line(char *line)
   if (gc_state.modal.coolant != gc_block.modal.coolant) {
     // NOTE: Coolant M-codes are modal. Only one command per line is allowed. But, multiple states
     // can exist at the same time, while coolant disable clears all states.
-    coolant_sync(gc_block.modal.coolant);
+    if (!gc_queue_accessory_update(PL_ACCESSORY_UPDATE_COOLANT)) { coolant_sync(gc_block.modal.coolant); }
     if (gc_block.modal.coolant == COOLANT_DISABLE) { gc_state.modal.coolant = COOLANT_DISABLE; }
     else { gc_state.modal.coolant |= gc_block.modal.coolant; }
   }
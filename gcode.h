@@ -238,4 +238,7 @@ uint8_t gc_execute_line(char *line);
 // Set g-code parser position. Input in steps.
 void gc_sync_position();
 
+// Computes the work coordinate offset of the parser state in mm, including tool length offset.
+void gc_get_wco(float *wco);
+
 #endif
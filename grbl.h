@@ -69,6 +69,9 @@
 #include "spindle_control.h"
 #include "stepper.h"
 #include "jog.h"
+#include "binary_motion.h"
+#include "sequenced_stream.h"
+#include "journal.h"
 
 // ---------------------------------------------------------------------------------------
 // COMPILE-TIME ERROR CHECKING OF DEFINE VALUES:
@@ -97,6 +100,22 @@
   #endif
 #endif
 
+#if defined(ENABLE_PROGRAM_MODE) && !defined(CARVIN)
+  #error "ENABLE_PROGRAM_MODE requires the Carvin timer5 time base"
+#endif
+
+#if defined(HOMING_STALLGUARD) && (!defined(CARVIN) || defined(COREXY))
+  #error "HOMING_STALLGUARD requires the Carvin TMC26x drivers and doesn't support COREXY."
+#endif
+
+#if defined(ENABLE_MOTOR_LOAD_TELEMETRY) && !defined(CARVIN)
+  #error "ENABLE_MOTOR_LOAD_TELEMETRY requires the Carvin TMC26x drivers."
+#endif
+
+#if defined(ENABLE_RT_LATENCY_STATS) && !defined(CARVIN)
+  #error "ENABLE_RT_LATENCY_STATS requires the Carvin timer5 time base."
+#endif
+
 #if (REPORT_WCO_REFRESH_BUSY_COUNT < REPORT_WCO_REFRESH_IDLE_COUNT)
   #error "WCO busy refresh is less than idle refresh."
 #endif
@@ -0,0 +1,194 @@
+/*
+  journal.c - wear-leveled EEPROM record journal
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  The journal stores frequently written values, like the coordinate offsets, as small records
+  appended to a ring of fixed-size slots, instead of rewriting them in place. Each slot holds:
+
+    [seq] [key] [data] [crc]
+    - seq: 16-bit little-endian sequence number, incremented by one per record written.
+    - key: JOURNAL_KEY value the record belongs to.
+    - data: JOURNAL_DATA_SIZE bytes, zero padded.
+    - crc: CRC-8 (CCITT) of all preceding record bytes.
+
+  Records are always written at the head slot, so the ring holds them in sequence order and the
+  newest valid record of a key supersedes the older ones. A record torn by a power loss fails its
+  CRC and is ignored, leaving the previous record of its key in effect. Before the head runs into
+  the oldest slots, they are reclaimed: stale records are dropped, and records still in effect are
+  copied to the head first. Writes are spread evenly over the whole region this way, and go out
+  through the EEPROM write queue, so neither appending nor reclaiming stalls the main program.
+*/
+
+#include "grbl.h"
+#include <util/crc16.h>
+
+#ifdef ENABLE_EEPROM_JOURNAL
+
+#define JOURNAL_RECORD_SEQ  0 // Byte offsets within a record.
+#define JOURNAL_RECORD_KEY  2
+#define JOURNAL_RECORD_DATA 3
+#define JOURNAL_RECORD_CRC  (JOURNAL_RECORD_SIZE-1)
+
+#define JOURNAL_NONE 0xff // Empty slot or key without a record.
+#define JOURNAL_MIN_FREE 2 // Free slots kept ahead of the head. Includes the one being written.
+
+typedef struct {
+  uint8_t slot_key[JOURNAL_N_SLOTS]; // Key of the valid record in each slot, or JOURNAL_NONE.
+  uint8_t key_slot[JOURNAL_N_KEYS];  // Slot of the newest record of each key, or JOURNAL_NONE.
+  uint8_t head;     // Next slot to write.
+  uint8_t tail;     // Oldest slot that may hold a record in effect. Ends the free slots.
+  uint8_t n_free;   // Number of slots from head up to tail, free to write.
+  uint16_t seq;     // Sequence number of the next record.
+} journal_t;
+static journal_t journal;
+
+
+static uint8_t journal_next_slot(uint8_t slot)
+{
+  if (++slot == JOURNAL_N_SLOTS) { slot = 0; }
+  return(slot);
+}
+
+
+// Returns true, if the slot holds the newest record of its key.
+static uint8_t journal_slot_in_effect(uint8_t slot)
+{
+  uint8_t key = journal.slot_key[slot];
+  return((key != JOURNAL_NONE) && (journal.key_slot[key] == slot));
+}
+
+
+static uint8_t journal_crc(uint8_t *record)
+{
+  uint8_t crc = 0;
+  uint8_t idx;
+  for (idx=0; idx<JOURNAL_RECORD_CRC; idx++) { crc = _crc8_ccitt_update(crc, record[idx]); }
+  return(crc);
+}
+
+
+// Reads the record of a slot. Returns false, if the slot is empty or the record is corrupted.
+static uint8_t journal_read_slot(uint8_t slot, uint8_t *record)
+{
+  memcpy_from_eeprom_no_checksum((char*)record, JOURNAL_EEPROM_START+slot*JOURNAL_RECORD_SIZE,
+                                 JOURNAL_RECORD_SIZE);
+  if (record[JOURNAL_RECORD_KEY] >= JOURNAL_N_KEYS) { return(false); } // Also erased EEPROM.
+  return(journal_crc(record) == record[JOURNAL_RECORD_CRC]);
+}
+
+
+// Writes a record at the head slot. Caller must ensure the head slot is free.
+static void journal_append(uint8_t key, uint8_t *data)
+{
+  uint8_t record[JOURNAL_RECORD_SIZE];
+  record[JOURNAL_RECORD_SEQ] = journal.seq & 0xff;
+  record[JOURNAL_RECORD_SEQ+1] = journal.seq >> 8;
+  record[JOURNAL_RECORD_KEY] = key;
+  memcpy(&record[JOURNAL_RECORD_DATA], data, JOURNAL_DATA_SIZE);
+  record[JOURNAL_RECORD_CRC] = journal_crc(record);
+  memcpy_to_eeprom_no_checksum(JOURNAL_EEPROM_START+journal.head*JOURNAL_RECORD_SIZE,
+                               (char*)record, JOURNAL_RECORD_SIZE);
+  journal.slot_key[journal.head] = key;
+  journal.key_slot[key] = journal.head;
+  journal.head = journal_next_slot(journal.head);
+  journal.n_free--;
+  journal.seq++;
+}
+
+
+void journal_init()
+{
+  uint8_t record[JOURNAL_RECORD_SIZE];
+  uint8_t slot;
+  uint8_t newest = JOURNAL_NONE;
+  uint16_t seq;
+  memset(journal.slot_key, JOURNAL_NONE, sizeof(journal.slot_key));
+  memset(journal.key_slot, JOURNAL_NONE, sizeof(journal.key_slot));
+  journal.seq = 0;
+
+  // Find the newest valid record. Sequence numbers wrap, but all records in the region are within
+  // JOURNAL_N_SLOTS of each other, so a signed difference orders them.
+  for (slot=0; slot<JOURNAL_N_SLOTS; slot++) {
+    if (journal_read_slot(slot, record)) {
+      journal.slot_key[slot] = record[JOURNAL_RECORD_KEY];
+      seq = record[JOURNAL_RECORD_SEQ] | (record[JOURNAL_RECORD_SEQ+1] << 8);
+      if ((newest == JOURNAL_NONE) || ((int16_t)(seq-journal.seq) > 0)) {
+        newest = slot;
+        journal.seq = seq;
+      }
+    }
+  }
+  journal.head = 0;
+  if (newest != JOURNAL_NONE) {
+    journal.head = journal_next_slot(newest);
+    journal.seq++;
+  }
+
+  // Index the records in ring order, oldest first, so the newest record of each key ends up in effect.
+  slot = journal.head;
+  do {
+    if (journal.slot_key[slot] != JOURNAL_NONE) { journal.key_slot[journal.slot_key[slot]] = slot; }
+    slot = journal_next_slot(slot);
+  } while (slot != journal.head);
+
+  // Slots after the head are free up to the oldest record still in effect.
+  journal.tail = journal.head;
+  journal.n_free = 0;
+  while ((journal.n_free < JOURNAL_N_SLOTS) && !journal_slot_in_effect(journal.tail)) {
+    journal.tail = journal_next_slot(journal.tail);
+    journal.n_free++;
+  }
+}
+
+
+void journal_write(uint8_t key, uint8_t *data, uint8_t size)
+{
+  uint8_t record[JOURNAL_RECORD_SIZE];
+  uint8_t record_data[JOURNAL_DATA_SIZE];
+  memset(record_data, 0, JOURNAL_DATA_SIZE);
+  memcpy(record_data, data, min(size, JOURNAL_DATA_SIZE));
+
+  // Reclaim the oldest slots until there is room. Records in effect are copied to the head. There
+  // are far fewer keys than slots, so the tail always reaches stale slots shortly.
+  uint8_t slot;
+  while (journal.n_free < JOURNAL_MIN_FREE) {
+    slot = journal.tail;
+    journal.tail = journal_next_slot(journal.tail);
+    journal.n_free++;
+    if (journal_slot_in_effect(slot)) {
+      journal_read_slot(slot, record);
+      journal_append(journal.slot_key[slot], &record[JOURNAL_RECORD_DATA]);
+    }
+  }
+  journal_append(key, record_data);
+}
+
+
+uint8_t journal_read(uint8_t key, uint8_t *data, uint8_t size)
+{
+  uint8_t record[JOURNAL_RECORD_SIZE];
+  uint8_t slot = journal.key_slot[key];
+  if (slot == JOURNAL_NONE) { return(false); }
+  if (!journal_read_slot(slot, record)) { return(false); }
+  memcpy(data, &record[JOURNAL_RECORD_DATA], min(size, JOURNAL_DATA_SIZE));
+  return(true);
+}
+
+#endif
@@ -0,0 +1,47 @@
+/*
+  journal.h - wear-leveled EEPROM record journal
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef journal_h
+#define journal_h
+
+// EEPROM region holding the journal. Placed in the upper 1KB of the ATmega2560 4KB EEPROM, clear
+// of the Grbl settings and the product settings at PS_SETTINGS_EEPROM_OFFSET.
+#ifndef JOURNAL_EEPROM_START
+  #define JOURNAL_EEPROM_START 0x0C00
+#endif
+#define JOURNAL_RECORD_SIZE 16 // Sequence number (2), key (1), data, and CRC-8 (1).
+#define JOURNAL_DATA_SIZE   (JOURNAL_RECORD_SIZE-4) // Fits the coordinate data of 3 axes.
+#define JOURNAL_N_SLOTS     64 // Region size is JOURNAL_N_SLOTS*JOURNAL_RECORD_SIZE bytes.
+
+// Record keys. Each key holds one value of up to JOURNAL_DATA_SIZE bytes.
+#define JOURNAL_N_KEYS 32
+#define JOURNAL_KEY_COORD(n)      (n)      // Coordinate data, by coord_select (0-15).
+#define JOURNAL_KEY_PS_SETTING(n) (16+(n)) // Product settings, by parameter index (0-15).
+
+// Scans the journal region and indexes the newest valid record of each key.
+void journal_init();
+
+// Appends a new record for key, superseding any older one. Reclaims the oldest slots as needed.
+void journal_write(uint8_t key, uint8_t *data, uint8_t size);
+
+// Reads the newest record of key into data. Returns false, if the journal holds none.
+uint8_t journal_read(uint8_t key, uint8_t *data, uint8_t size);
+
+#endif
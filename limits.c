@@ -30,6 +30,21 @@
   #define HOMING_AXIS_LOCATE_SCALAR  5.0 // Must be > 1 to ensure limit switch is cleared.
 #endif
 
+#ifdef HOMING_STALLGUARD
+  // StallGuard2 readings are polled at this interval [usec] during the seek.
+  #ifndef HOMING_STALLGUARD_POLL_US
+    #define HOMING_STALLGUARD_POLL_US 1000
+  #endif
+  // Readings are ignored while the axes accelerate to seek rate [usec]. They aren't valid at low speed.
+  #ifndef HOMING_STALLGUARD_BLANK_US
+    #define HOMING_STALLGUARD_BLANK_US 150000
+  #endif
+  // Consecutive readings under the threshold that make a stall. Rejects single noisy readings.
+  #ifndef HOMING_STALLGUARD_SAMPLES
+    #define HOMING_STALLGUARD_SAMPLES 2
+  #endif
+#endif
+
 void limits_init()
 {
   LIMIT_DDR &= ~(LIMIT_MASK); // Set as input pins
@@ -136,6 +151,29 @@ uint8_t limits_get_state()
   }
 #endif
 
+#ifdef HOMING_STALLGUARD
+  // Gets the stall thresholds of the cycle axes and returns the mask of axes homed by stall
+  // detection. Empty, unless all cycle axes have a threshold and a driver that verified at boot,
+  // so a cycle never mixes both methods. A dead driver may read as a stall, so those use the switches.
+  static uint8_t limits_stallguard_mask(uint8_t cycle_mask, uint16_t *threshold)
+  {
+    uint8_t sg_mask = 0;
+    uint8_t idx;
+    float value;
+    for (idx=0; idx<N_AXIS; idx++) {
+      threshold[idx] = 0;
+      if (bit_istrue(cycle_mask,bit(idx))) {
+        ps_settings_get_value(PS_SETTING_SG_HOMING_THRESHOLD_X+idx, &value);
+        threshold[idx] = (uint16_t)value;
+        if (threshold[idx]) { sg_mask |= bit(idx); }
+      }
+    }
+    if ((sg_mask != cycle_mask) || ((tmc26x_ready_mask & cycle_mask) != cycle_mask)) { return(0); }
+    return(sg_mask);
+  }
+#endif
+
+
 // Homes the specified cycle axes, sets the machine position, and performs a pull-off motion after
 // completing. Homing is a special motion case, which involves rapid uncontrolled stops to locate
 // the trigger point of the limit switches. The rapid stops are handled by a system level axis lock
@@ -158,6 +196,13 @@ void limits_go_home(uint8_t cycle_mask)
 
   // Initialize variables used for homing computations.
   uint8_t n_cycle = (2*N_HOMING_LOCATE_CYCLE+1);
+  #ifdef HOMING_STALLGUARD
+    uint16_t sg_threshold[N_AXIS];
+    uint8_t sg_count[N_AXIS];
+    uint32_t sg_start, sg_poll, sg_now;
+    uint8_t sg_mask = limits_stallguard_mask(cycle_mask, sg_threshold);
+    if (sg_mask) { n_cycle = 1; } // Single pass. Seek to the stall, then pull off.
+  #endif
   uint8_t step_pin[N_AXIS];
   float target[N_AXIS];
   float max_travel = 0.0;
@@ -230,6 +275,10 @@ void limits_go_home(uint8_t cycle_mask)
     sys.step_control = STEP_CONTROL_EXECUTE_SYS_MOTION; // Set to execute homing motion and clear existing flags.
     st_prep_buffer(); // Prep and fill segment buffer from newly planned block.
     st_wake_up(); // Initiate motion
+    #ifdef HOMING_STALLGUARD
+      sg_start = sg_poll = carvin_get_timer_count();
+      memset(sg_count,0,sizeof(sg_count));
+    #endif
     do {
       if (approach) {
         // Check limit state. Lock out cycle axes when they change.
@@ -246,6 +295,26 @@ void limits_go_home(uint8_t cycle_mask)
             }
           }
         }
+        #ifdef HOMING_STALLGUARD
+          // Lock out cycle axes that stalled. The drivers are read in the background, so each check
+          // sees the readings requested one poll interval earlier.
+          if (sg_mask) {
+            sg_now = carvin_get_timer_count();
+            if (carvin_get_elapsed_us(sg_poll,sg_now) >= HOMING_STALLGUARD_POLL_US) {
+              sg_poll = sg_now;
+              if (carvin_get_elapsed_us(sg_start,sg_now) >= HOMING_STALLGUARD_BLANK_US) {
+                for (idx=0; idx<N_AXIS; idx++) {
+                  if ((axislock & step_pin[idx]) && (tmc26xStallGuardReading(idx) < sg_threshold[idx])) {
+                    if (++sg_count[idx] >= HOMING_STALLGUARD_SAMPLES) { axislock &= ~(step_pin[idx]); }
+                  } else {
+                    sg_count[idx] = 0;
+                  }
+                }
+              }
+              tmc26x_request_status(READOUT_VALUE_SG2);
+            }
+          }
+        #endif
         sys.homing_axis_lock = axislock;
       }
 
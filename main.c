@@ -29,6 +29,9 @@ system_t sys;
 int main(void)
 {
   // Initialize system upon power-up.
+#ifdef CARVIN
+  carvin_boot_timer_start();  // measure power up to banner time, reported by '$I'
+#endif
   serial_init();   // Setup serial baud rate and interrupts
   settings_init(); // Load Grbl settings from EEPROM
 #ifdef CARVIN
@@ -79,6 +82,9 @@ int main(void)
     sys_rt_exec_accessory_override = 0;
 
     // Reset Grbl primary systems.
+    #ifdef ENABLE_BAUD_RATE_COMMAND
+      serial_set_baud_rate(BAUD_RATE); // Fall back to the default baud rate upon a reset.
+    #endif
     serial_reset_read_buffer(); // Clear serial read buffer
     gc_init(); // Set g-code parser to default state
     spindle_init();
@@ -94,6 +100,9 @@ int main(void)
     gc_sync_position();
 
     // Print welcome message. Indicates an initialization has occured at power-up or with a reset.
+    #ifdef CARVIN
+      carvin_record_boot_time();
+    #endif
     report_init_message();
     
     // Start Grbl main loop. Processes program inputs and executes them.
@@ -25,14 +25,17 @@
 #define MAX_INT_DIGITS 8 // Maximum number of digits in int32 (and float)
 
 
-// Extracts a floating point value from a string. The following code is based loosely on
-// the avr-libc strtod() function by Michael Stumpf and Dmitry Xmelkov and many freely
-// available conversion method examples, but has been highly optimized for Grbl. For known
-// CNC applications, the typical decimal value is expected to be in the range of E0 to E-4.
-// Scientific notation is officially not supported by g-code, and the 'E' character may
-// be a g-code word on some CNC systems. So, 'E' notation will not be recognized.
+// Extracts a decimal number from a string in a single pass, without any floating point math.
+// The following code is based loosely on the avr-libc strtod() function by Michael Stumpf and
+// Dmitry Xmelkov and many freely available conversion method examples, but has been highly
+// optimized for Grbl. For known CNC applications, the typical decimal value is expected to be in
+// the range of E0 to E-4. Scientific notation is officially not supported by g-code, and the 'E'
+// character may be a g-code word on some CNC systems. So, 'E' notation will not be recognized.
+// Along with the integer significand and decimal exponent, the truncated integer part and the
+// rounded hundredths are captured for g-code command words, such as G38.2, so that they never
+// require a float conversion.
 // NOTE: Thanks to Radu-Eosif Mihailescu for identifying the issues with using strtod().
-uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
+uint8_t read_number(char *line, uint8_t *char_counter, number_t *number)
 {
   char *ptr = line + *char_counter;
   unsigned char c;
@@ -41,9 +44,9 @@ uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
   c = *ptr++;
 
   // Capture initial positive/minus character
-  bool isnegative = false;
+  number->isnegative = false;
   if (c == '-') {
-    isnegative = true;
+    number->isnegative = true;
     c = *ptr++;
   } else if (c == '+') {
     c = *ptr++;
@@ -51,8 +54,11 @@ uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
 
   // Extract number into fast integer. Track decimal in terms of exponent value.
   uint32_t intval = 0;
+  uint32_t int_part = 0;
   int8_t exp = 0;
   uint8_t ndigit = 0;
+  uint8_t nfraction = 0; // Number of fraction digits read. Zero when no decimal point.
+  uint8_t mantissa = 0;
   bool isdecimal = false;
   while(1) {
     c -= '0';
@@ -64,6 +70,15 @@ uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
       } else {
         if (!(isdecimal)) { exp++; }  // Drop overflow digits
       }
+      if (isdecimal) {
+        // Capture hundredths of command words. Third fraction digit rounds.
+        nfraction++;
+        if (nfraction == 1) { mantissa = (((c << 2) + c) << 1); } // c*10
+        else if (nfraction == 2) { mantissa += c; }
+        else if (nfraction == 3) { if (c >= 5) { mantissa++; } }
+      } else {
+        int_part = intval;
+      }
     } else if (c == (('.'-'0') & 0xff)  &&  !(isdecimal)) {
       isdecimal = true;
     } else {
@@ -75,12 +90,27 @@ uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
   // Return if no digits have been read.
   if (!ndigit) { return(false); };
 
+  number->significand = intval;
+  number->exponent = exp;
+  number->int_value = int_part;
+  number->mantissa = mantissa;
+
+  *char_counter = ptr - line - 1; // Set char_counter to next statement
+
+  return(true);
+}
+
+
+// Converts a number extracted by read_number() into floating point.
+float number_to_float(number_t *number)
+{
   // Convert integer into floating point.
   float fval;
-  fval = (float)intval;
+  fval = (float)number->significand;
 
   // Apply decimal. Should perform no more than two floating point multiplications for the
   // expected range of E0 to E-4.
+  int8_t exp = number->exponent;
   if (fval != 0) {
     while (exp <= -2) {
       fval *= 0.01;
@@ -95,19 +125,56 @@ uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
     }
   }
 
-  // Assign floating point value with correct sign.
-  if (isnegative) {
-    *float_ptr = -fval;
-  } else {
-    *float_ptr = fval;
-  }
+  // Return floating point value with correct sign.
+  if (number->isnegative) { return(-fval); }
+  return(fval);
+}
 
-  *char_counter = ptr - line - 1; // Set char_counter to next statement
 
+// Extracts a floating point value from a string. See read_number().
+uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
+{
+  number_t number;
+  if (!read_number(line, char_counter, &number)) { return(false); }
+  *float_ptr = number_to_float(&number);
   return(true);
 }
 
 
+// Returns the 6-bit value of a base64 character or 0xff, if it's not one.
+static uint8_t base64_char_value(char c)
+{
+  if ((c >= 'A') && (c <= 'Z')) { return(c-'A'); }
+  if ((c >= 'a') && (c <= 'z')) { return(c-'a'+26); }
+  if ((c >= '0') && (c <= '9')) { return(c-'0'+52); }
+  if (c == '+') { return(62); }
+  if (c == '/') { return(63); }
+  return(0xff);
+}
+
+
+// Decodes unpadded base64 from line up to its end. Returns the data size or zero upon failure.
+uint8_t read_base64(char *line, uint8_t *data, uint8_t max_size)
+{
+  uint16_t bit_buffer = 0;
+  uint8_t bit_count = 0;
+  uint8_t size = 0;
+  uint8_t value;
+  while (*line != 0) {
+    value = base64_char_value(*line++);
+    if (value == 0xff) { return(0); }
+    bit_buffer = (bit_buffer << 6) | value;
+    bit_count += 6;
+    if (bit_count >= 8) {
+      if (size == max_size) { return(0); }
+      bit_count -= 8;
+      data[size++] = bit_buffer >> bit_count;
+    }
+  }
+  return(size);
+}
+
+
 // Non-blocking delay function used for general operation and suspend features.
 void delay_sec(float seconds, uint8_t mode)
 {
@@ -75,11 +75,34 @@
 #define bit_istrue(x,mask) ((x & mask) != 0)
 #define bit_isfalse(x,mask) ((x & mask) == 0)
 
+// Decimal number extracted from a string. Value is the significand times ten to the exponent,
+// negated if isnegative is set. int_value and mantissa hold the truncated integer part and the
+// rounded hundredths of the value, as used by g-code command words like G38.2.
+typedef struct {
+  uint32_t significand;
+  int8_t exponent;
+  uint8_t isnegative;
+  uint8_t int_value;
+  uint8_t mantissa;
+} number_t;
+
+// Read a decimal number from a string without floating point conversion. Line points to the
+// input buffer and char_counter is the indexer pointing to the current character of the line.
+// Returns true when it succeeds.
+uint8_t read_number(char *line, uint8_t *char_counter, number_t *number);
+
+// Converts a number from read_number() into floating point.
+float number_to_float(number_t *number);
+
 // Read a floating point value from a string. Line points to the input buffer, char_counter
 // is the indexer pointing to the current character of the line, while float_ptr is
 // a pointer to the result variable. Returns true when it succeeds
 uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr);
 
+// Decodes an unpadded base64 string, standard alphabet, into at most max_size bytes of data.
+// Returns the data size or zero upon an invalid character or overflow.
+uint8_t read_base64(char *line, uint8_t *data, uint8_t max_size);
+
 // Non-blocking delay function used for general operation and suspend features.
 void delay_sec(float seconds, uint8_t mode);
 
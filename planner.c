@@ -324,6 +324,12 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
   #ifdef USE_LINE_NUMBERS
     block->line_number = pl_data->line_number;
   #endif
+  #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+    // Tag block with the work coordinate offset in effect for it. System motions, like homing and
+    // parking, retain the offset of the executing motion.
+    if (block->condition & PL_COND_FLAG_SYSTEM_MOTION) { system_get_wco(block->wco); }
+    else { gc_get_wco(block->wco); }
+  #endif
 
   // Compute and store initial move distance data.
   int32_t target_steps[N_AXIS], position_steps[N_AXIS];
@@ -461,6 +467,12 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
     memcpy(pl.previous_unit_vec, unit_vec, sizeof(unit_vec)); // pl.previous_unit_vec[] = unit_vec[]
     memcpy(pl.position, target_steps, sizeof(target_steps)); // pl.position[] = target_steps[]
 
+    #ifdef ENABLE_QUEUED_ACCESSORY_STATE
+      // Attach accessory changes queued by the g-code parser since the last planned block.
+      block->accessory_update = sys.accessory_update;
+      sys.accessory_update = 0;
+    #endif
+
     // New block is all set. Update buffer head and next buffer head indices.
     block_buffer_head = next_buffer_head;
     next_buffer_head = plan_next_block_index(block_buffer_head);
@@ -48,6 +48,11 @@
 #define PL_COND_MOTION_MASK    (PL_COND_FLAG_RAPID_MOTION|PL_COND_FLAG_SYSTEM_MOTION|PL_COND_FLAG_NO_FEED_OVERRIDE)
 #define PL_COND_ACCESSORY_MASK (PL_COND_FLAG_SPINDLE_CW|PL_COND_FLAG_SPINDLE_CCW|PL_COND_FLAG_COOLANT_FLOOD|PL_COND_FLAG_COOLANT_MIST)
 
+// Define planner block accessory update flags. Used to apply queued accessory state changes,
+// stored in the block condition, when the block starts executing.
+#define PL_ACCESSORY_UPDATE_SPINDLE  bit(0)
+#define PL_ACCESSORY_UPDATE_COOLANT  bit(1)
+
 
 // This struct stores a linear movement of a g-code block motion with its critical "nominal" values
 // are as specified in the source g-code.
@@ -63,6 +68,12 @@ typedef struct {
   #ifdef USE_LINE_NUMBERS
     int32_t line_number;  // Block line number for real-time reporting. Copied from pl_line_data.
   #endif
+  #ifdef ENABLE_QUEUED_ACCESSORY_STATE
+    uint8_t accessory_update; // Queued accessory changes to apply when block starts. Copied from sys.
+  #endif
+  #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+    float wco[N_AXIS];    // Work coordinate offset the block was planned with. For status reports.
+  #endif
 
   // Fields used by the motion planner to manage acceleration. Some of these values may be updated
   // by the stepper module during execution of special motion cases for replanning purposes.
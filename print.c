@@ -22,6 +22,19 @@
 #include "grbl.h"
 
 
+// Powers of ten for the digit generator. Digits are found by repeated subtraction, since a 32-bit
+// divide on the AVR takes several hundred cycles per digit.
+static const uint32_t print_pow10[] PROGMEM = {
+  1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL, 10000UL, 1000UL, 100UL, 10UL };
+
+// Per-axis step to coordinate unit scale, as 16.32 fixed-point. Units are the least significant
+// printed digit of a coordinate value in mm or inches. Updated by print_coord_scale_init().
+static uint16_t coord_scale_whole[N_AXIS];
+static uint32_t coord_scale_fraction[N_AXIS];
+static float coord_units_per_mm;
+static uint8_t coord_decimal_places;
+
+
 void printString(const char *s)
 {
   while (*s)
@@ -80,6 +93,32 @@ void print_uint8_base10(uint8_t n)
 
 
 // Prints an uint8 variable in base 2 with desired number of desired digits.
+static void print_base64_char(uint8_t value)
+{
+  if (value < 26) { serial_write('A'+value); }
+  else if (value < 52) { serial_write('a'+value-26); }
+  else if (value < 62) { serial_write('0'+value-52); }
+  else if (value == 62) { serial_write('+'); }
+  else { serial_write('/'); }
+}
+
+
+void print_base64(uint8_t *data, uint8_t size)
+{
+  uint16_t bit_buffer = 0;
+  uint8_t bit_count = 0;
+  while (size--) {
+    bit_buffer = (bit_buffer << 8) | *data++;
+    bit_count += 8;
+    while (bit_count >= 6) {
+      bit_count -= 6;
+      print_base64_char((bit_buffer >> bit_count) & 0x3f);
+    }
+  }
+  if (bit_count) { print_base64_char((bit_buffer << (6-bit_count)) & 0x3f); } // Zero padded bits
+}
+
+
 void print_uint8_base2_ndigit(uint8_t n, uint8_t digits) {
   unsigned char buf[digits];
   uint8_t i = 0;
@@ -94,23 +133,36 @@ void print_uint8_base2_ndigit(uint8_t n, uint8_t digits) {
 }
 
 
-void print_uint32_base10(uint32_t n)
+// Prints an uint32 variable in base 10, with a decimal point inserted before the last
+// decimal_places digits. Zeros are filled in up to the decimal point.
+static void print_uint32_fixed_point(uint32_t n, uint8_t decimal_places)
 {
-  if (n == 0) {
-    serial_write('0');
-    return;
+  uint8_t place = 9; // Power of ten of the current digit.
+  uint8_t idx;
+  uint8_t started = false;
+  uint32_t power;
+  char digit;
+  for (idx=0; idx<9; idx++) {
+    power = pgm_read_dword(&print_pow10[idx]);
+    digit = '0';
+    while (n >= power) {
+      n -= power;
+      digit++;
+    }
+    if (started || (digit != '0') || (place <= decimal_places)) {
+      serial_write(digit);
+      started = true;
+      if (place == decimal_places) { serial_write('.'); }
+    }
+    place--;
   }
+  serial_write('0' + n);
+}
 
-  unsigned char buf[10];
-  uint8_t i = 0;
 
-  while (n > 0) {
-    buf[i++] = n % 10;
-    n /= 10;
-  }
-
-  for (; i > 0; i--)
-    serial_write('0' + buf[i-1]);
+void print_uint32_base10(uint32_t n)
+{
+  print_uint32_fixed_point(n, 0);
 }
 
 
@@ -127,9 +179,7 @@ void printInteger(long n)
 
 // Convert float to string by immediately converting to a long integer, which contains
 // more digits than a float. Number of decimal places, which are tracked by a counter,
-// may be set by the user. The integer is then efficiently converted to a string.
-// NOTE: AVR '%' and '/' integer operations are very efficient. Bitshifting speed-up
-// techniques are actually just slightly slower. Found this out the hard way.
+// may be set by the user. The integer is then converted to a string without any divides.
 void printFloat(float n, uint8_t decimal_places)
 {
   if (n < 0) {
@@ -145,26 +195,7 @@ void printFloat(float n, uint8_t decimal_places)
   if (decimals) { n *= 10; }
   n += 0.5; // Add rounding factor. Ensures carryover through entire value.
 
-  // Generate digits backwards and store in string.
-  unsigned char buf[13];
-  uint8_t i = 0;
-  uint32_t a = (long)n;
-  while(a > 0) {
-    buf[i++] = (a % 10) + '0'; // Get digit
-    a /= 10;
-  }
-  while (i < decimal_places) {
-     buf[i++] = '0'; // Fill in zeros to decimal point for (n < 1)
-  }
-  if (i == decimal_places) { // Fill in leading zero, if needed.
-    buf[i++] = '0';
-  }
-
-  // Print the generated string.
-  for (; i > 0; i--) {
-    if (i == decimal_places) { serial_write('.'); } // Insert decimal point in right place.
-    serial_write(buf[i-1]);
-  }
+  print_uint32_fixed_point((long)n, decimal_places);
 }
 
 
@@ -180,6 +211,68 @@ void printFloat_CoordValue(float n) {
   }
 }
 
+// Computes the fixed-point step to coordinate unit scale of each axis. Must be called whenever the
+// steps per mm or the report inches setting change.
+void print_coord_scale_init()
+{
+  uint8_t idx;
+  if (bit_istrue(settings.flags,BITFLAG_REPORT_INCHES)) {
+    coord_decimal_places = N_DECIMAL_COORDVALUE_INCH;
+    coord_units_per_mm = INCH_PER_MM;
+  } else {
+    coord_decimal_places = N_DECIMAL_COORDVALUE_MM;
+    coord_units_per_mm = 1.0;
+  }
+  for (idx=0; idx<coord_decimal_places; idx++) { coord_units_per_mm *= 10; }
+
+  float scale;
+  for (idx=0; idx<N_AXIS; idx++) {
+    scale = coord_units_per_mm/settings.steps_per_mm[idx];
+    coord_scale_whole[idx] = trunc(scale);
+    scale = (scale-coord_scale_whole[idx])*4294967296.0;
+    if (scale > 4294967295.0) { scale = 4294967295.0; } // Guard against float rounding.
+    coord_scale_fraction[idx] = scale;
+  }
+}
+
+
+// Converts an axis position in steps to coordinate units, rounded to nearest. Uses 16x16-bit
+// partial products of the fixed-point scale, which the AVR hardware multiplier handles quickly.
+int32_t print_convert_steps_to_coord_units(int32_t steps, uint8_t idx)
+{
+  uint32_t n = labs(steps);
+  uint16_t n_high = n >> 16;
+  uint16_t n_low = n & 0xffff;
+  uint16_t fraction_high = coord_scale_fraction[idx] >> 16;
+  uint16_t fraction_low = coord_scale_fraction[idx] & 0xffff;
+  uint32_t mid_a = (uint32_t)n_low*fraction_high;
+  uint32_t mid_b = (uint32_t)n_high*fraction_low;
+  uint32_t mid = (((uint32_t)n_low*fraction_low) >> 16) + (mid_a & 0xffff) + (mid_b & 0xffff) + 0x8000;
+  uint32_t units = n*coord_scale_whole[idx] + (uint32_t)n_high*fraction_high +
+                   (mid_a >> 16) + (mid_b >> 16) + (mid >> 16);
+  if (steps < 0) { return(-(int32_t)units); }
+  return(units);
+}
+
+
+// Converts a value in mm to coordinate units, rounded to nearest.
+int32_t print_convert_mm_to_coord_units(float n)
+{
+  return(lround(n*coord_units_per_mm));
+}
+
+
+// Prints a value in coordinate units, like printFloat_CoordValue() prints the value in mm.
+void printCoord_Units(int32_t n)
+{
+  if (n < 0) {
+    serial_write('-');
+    n = -n;
+  }
+  print_uint32_fixed_point(n, coord_decimal_places);
+}
+
+
 void printFloat_RateValue(float n) {
   if (bit_istrue(settings.flags,BITFLAG_REPORT_INCHES)) {
     printFloat(n*INCH_PER_MM,N_DECIMAL_RATEVALUE_INCH);
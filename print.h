@@ -39,12 +39,22 @@ void print_uint8_base2_ndigit(uint8_t n, uint8_t digits);
 
 void printFloat(float n, uint8_t decimal_places);
 
+// Prints data as unpadded base64, standard alphabet. Decoded by read_base64().
+void print_base64(uint8_t *data, uint8_t size);
+
 // Floating value printing handlers for special variables types used in Grbl.
 //  - CoordValue: Handles all position or coordinate values in inches or mm reporting.
 //  - RateValue: Handles feed rate and current velocity in inches or mm reporting.
 void printFloat_CoordValue(float n);
 void printFloat_RateValue(float n);
 
+// Integer coordinate printing. Positions are converted straight from steps to coordinate units,
+// the least significant printed digit in mm or inches, with a per-axis fixed-point scale.
+void print_coord_scale_init();
+int32_t print_convert_steps_to_coord_units(int32_t steps, uint8_t idx);
+int32_t print_convert_mm_to_coord_units(float n);
+void printCoord_Units(int32_t n);
+
 // Debug tool to print free memory in bytes at the called point. Not used otherwise.
 void printFreeMemory();
 
@@ -32,6 +32,21 @@ static char line[LINE_BUFFER_SIZE]; // Line to be executed. Zero-terminated.
 
 static void protocol_exec_rt_suspend();
 
+#ifdef ENABLE_PROGRAM_MODE
+  #define PROGRAM_MODE_START_TICKS ((uint16_t)(PROGRAM_MODE_START_DELAY*CARVIN_TICKS_PER_SECOND))
+  static void protocol_program_cycle_start(uint16_t line_tick);
+#endif
+
+
+// Reports the status of an executed line. Sequenced lines are acknowledged by sequence number.
+static void protocol_report_line_status(uint8_t status_code)
+{
+  #ifdef ENABLE_SEQUENCED_STREAM
+    if (ss_report_status(status_code)) { return; }
+  #endif
+  report_status_message(status_code);
+}
+
 
 /*
   GRBL PRIMARY LOOP:
@@ -76,6 +91,9 @@ void protocol_main_loop()
   uint8_t line_flags = 0;
   uint8_t char_counter = 0;
   uint8_t c;
+  #ifdef ENABLE_PROGRAM_MODE
+    uint16_t line_tick = 0; // Time the last line was received. Used by program mode.
+  #endif
   for (;;) {
 
     // Process one line of incoming serial data, as the data becomes available. Performs an
@@ -92,29 +110,72 @@ void protocol_main_loop()
         #endif
 
         // Direct and execute one line of formatted input, and report status of execution.
+        #ifdef ENABLE_SEQUENCED_STREAM
+          if (sys.sequenced_stream && !ss_end_line()) {
+            // Corrupted, lost, or repeated sequenced line. Discarded without executing.
+          } else
+        #endif
         if (line_flags & LINE_FLAG_OVERFLOW) {
           // Report line overflow error.
-          report_status_message(STATUS_OVERFLOW);
+          protocol_report_line_status(STATUS_OVERFLOW);
         } else if (line[0] == 0) {
           // Empty or comment line. For syncing purposes.
-          report_status_message(STATUS_OK);
+          protocol_report_line_status(STATUS_OK);
         } else if (line[0] == '$') {
           // Grbl '$' system command
-          report_status_message(system_execute_line(line));
+          protocol_report_line_status(system_execute_line(line));
+          #ifdef ENABLE_BAUD_RATE_COMMAND
+            if (sys.baud_rate_request) {
+              #ifdef ENABLE_SEQUENCED_STREAM
+                // The '$U' ok must go out at the current rate. Send the batched acknowledgment now.
+                // serial_negotiate_baud_rate() drains the TX buffer before switching.
+                if (sys.sequenced_stream) { ss_flush_ack(); }
+              #endif
+              serial_negotiate_baud_rate(sys.baud_rate_request);
+              sys.baud_rate_request = 0;
+            }
+          #endif
         } else if (sys.state & (STATE_ALARM | STATE_JOG)) {
           // Everything else is gcode. Block if in alarm or jog mode.
-          report_status_message(STATUS_SYSTEM_GC_LOCK);
+          protocol_report_line_status(STATUS_SYSTEM_GC_LOCK);
+        #ifdef ENABLE_BINARY_MOTION_STREAM
+          } else if (sys.binary_motion) {
+            // Decode and execute binary motion frame.
+            protocol_report_line_status(bm_execute_frame(line));
+        #endif
         } else {
           // Parse and execute g-code block.
-          report_status_message(gc_execute_line(line));
+          protocol_report_line_status(gc_execute_line(line));
         }
 
         // Reset tracking data for next line.
         line_flags = 0;
         char_counter = 0;
+        #ifdef ENABLE_PROGRAM_MODE
+          line_tick = carvin_get_tick_count();
+        #endif
 
       } else {
 
+        #ifdef ENABLE_SEQUENCED_STREAM
+          if (sys.sequenced_stream && ss_process_char(c)) {
+            // Sequence number and checksum framing. Not part of the line.
+          } else
+        #endif
+        #ifdef ENABLE_BINARY_MOTION_STREAM
+          if (sys.binary_motion) {
+            // Binary motion frames are case-sensitive and may contain '/'. Store characters as-is.
+            // NOTE: '$' system commands are also stored as-is and must be sent in upper case.
+            if (c <= ' ') {
+              // Throw away whitepace and control characters
+            } else if (char_counter >= (LINE_BUFFER_SIZE-1)) {
+              // Detect line buffer overflow and set flag.
+              line_flags |= LINE_FLAG_OVERFLOW;
+            } else {
+              line[char_counter++] = c;
+            }
+          } else
+        #endif
         if (line_flags) {
           // Throw away all (except EOL) comment characters and overflow characters.
           if (c == ')') {
@@ -136,13 +197,13 @@ void protocol_main_loop()
           } else if (c == ';') {
             // NOTE: ';' comment to EOL is a LinuxCNC definition. Not NIST.
             line_flags |= LINE_FLAG_COMMENT_SEMICOLON;
-          // TODO: Install '%' feature
-          // } else if (c == '%') {
-            // Program start-end percent sign NOT SUPPORTED.
-            // NOTE: This maybe installed to tell Grbl when a program is running vs manual input,
-            // where, during a program, the system auto-cycle start will continue to execute
-            // everything until the next '%' sign. This will help fix resuming issues with certain
-            // functions that empty the planner buffer to execute its task on-time.
+          #ifdef ENABLE_PROGRAM_MODE
+            } else if (c == '%') {
+              // Program start-end percent sign. Tells Grbl when a program is running vs manual input.
+              // The character itself is removed, so a '%' line is acknowledged as an empty line.
+              // NOTE: When disabled, '%' is passed to the parser and errors as before.
+              sys.program_mode = !sys.program_mode;
+          #endif
           } else if (char_counter >= (LINE_BUFFER_SIZE-1)) {
             // Detect line buffer overflow and set flag.
             line_flags |= LINE_FLAG_OVERFLOW;
@@ -156,9 +217,18 @@ void protocol_main_loop()
       }
     }
 
+    #ifdef ENABLE_SEQUENCED_STREAM
+      // Serial read buffer is empty. Acknowledge all lines executed since the last acknowledgment.
+      if (sys.sequenced_stream) { ss_flush_ack(); }
+    #endif
+
     // If there are no more characters in the serial read buffer to be processed and executed,
     // this indicates that g-code streaming has either filled the planner buffer or has
     // completed. In either case, auto-cycle start, if enabled, any queued moves.
+    #ifdef ENABLE_PROGRAM_MODE
+      if (sys.program_mode) { protocol_program_cycle_start(line_tick); }
+      else
+    #endif
     protocol_auto_cycle_start();
 
     protocol_execute_realtime();  // Runtime command check point.
@@ -202,6 +272,22 @@ void protocol_auto_cycle_start()
 }
 
 
+#ifdef ENABLE_PROGRAM_MODE
+// Main loop auto-cycle start while in program mode. When idle, holds off the cycle start until
+// enough blocks are queued for the planner to look ahead over, or no line has been received for
+// the program mode start delay. Buffer syncs and a full planner buffer still start immediately.
+static void protocol_program_cycle_start(uint16_t line_tick)
+{
+  if (sys.state == STATE_IDLE) {
+    if (plan_get_block_buffer_count() < PROGRAM_MODE_START_BLOCKS) {
+      if ((uint16_t)(carvin_get_tick_count() - line_tick) < PROGRAM_MODE_START_TICKS) { return; }
+    }
+  }
+  protocol_auto_cycle_start();
+}
+#endif
+
+
 // This function is the general interface to Grbl's real-time command execution system. It is called
 // from various check points in the main program, primarily where there may be a while loop waiting
 // for a buffer to clear space or any point where the execution time from the last check point may
@@ -215,6 +301,13 @@ void protocol_auto_cycle_start()
 // limit switches, or the main program.
 void protocol_execute_realtime()
 {
+  serial_flush(); // Send any partial line, like a prompt, before possibly blocking.
+  #ifdef CARVIN
+    carvin_settings_proc(); // Apply product setting changes outside of the Timer5 ISR.
+    #ifdef ENABLE_MOTOR_LOAD_TELEMETRY
+      carvin_report_motor_stall(); // Print a motor stall flagged by the Timer5 ISR.
+    #endif
+  #endif
   protocol_exec_rt_system();
   if (sys.suspend) { protocol_exec_rt_suspend(); }
 }
@@ -225,6 +318,10 @@ void protocol_execute_realtime()
 // NOTE: Do not alter this unless you know exactly what you are doing!
 void protocol_exec_rt_system()
 {
+  #ifdef ENABLE_RT_LATENCY_STATS
+    system_rt_latency_end(); // Realtime commands received so far are serviced now.
+  #endif
+
   uint8_t rt_exec; // Temp variable to avoid calling volatile multiple times.
   rt_exec = sys_rt_exec_alarm; // Copy volatile sys_rt_exec_alarm.
   if (rt_exec) { // Enter only if any bit flag is true
@@ -305,6 +402,9 @@ void protocol_exec_rt_system()
         // NOTE: Safety door differs from feed holds by stopping everything no matter state, disables powered
         // devices (spindle/coolant), and blocks resuming until switch is re-engaged.
         if (rt_exec & EXEC_SAFETY_DOOR) {
+          #ifdef CARVIN
+            carvin_report_overcurrent();
+          #endif
           report_feedback_message(MESSAGE_SAFETY_DOOR_AJAR);
           // If jogging, block safety door methods until jog cancel is complete. Just flag that it happened.
           if (!(sys.suspend & SUSPEND_JOG_CANCEL)) {
@@ -414,6 +514,33 @@ void protocol_exec_rt_system()
           sys.suspend = SUSPEND_DISABLE;
           sys.state = STATE_IDLE;
         }
+        #ifdef ENABLE_QUEUED_ACCESSORY_STATE
+          // Apply accessory changes queued after the last planned motion, now that it's complete.
+          // NOTE: The parser state is the programmed state, since all of its motions have executed.
+          if (sys.accessory_update & PL_ACCESSORY_UPDATE_SPINDLE) {
+            spindle_set_state(gc_state.modal.spindle, gc_state.spindle_speed);
+          }
+          if (sys.accessory_update & PL_ACCESSORY_UPDATE_COOLANT) { coolant_set_state(gc_state.modal.coolant); }
+          sys.accessory_update = 0;
+          // Spindle changes applied by the stepper skip spindle_set_state(). Update its reported state.
+          if (sys.accessory_applied & PL_ACCESSORY_UPDATE_SPINDLE) {
+            #ifdef VARIABLE_SPINDLE
+              if (gc_state.modal.spindle == SPINDLE_DISABLE) { sys.spindle_speed = 0.0; }
+              else { spindle_compute_pwm_value(gc_state.spindle_speed); } // Sets sys.spindle_speed only.
+            #endif
+            sys.report_ovr_counter = 0; // Set to report change immediately
+          }
+          sys.accessory_applied = 0;
+        #endif
+        #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+          // Sync the reported offset to any change queued after the last planned motion.
+          float wco[N_AXIS];
+          gc_get_wco(wco);
+          if (memcmp(sys_wco, wco, sizeof(wco))) {
+            memcpy(sys_wco, wco, sizeof(wco));
+            sys.report_wco_counter = 0; // Set to report change immediately
+          }
+        #endif
       }
       system_clear_exec_state_flag(EXEC_CYCLE_STOP);
     }
@@ -7,97 +7,119 @@
 
 #include "ps_settings.h"
 #include "string.h"
-#include "stdlib.h"
+#include "math.h"
 
+#include "config.h"
 #include "eeprom.h"
+#include "journal.h"
 #include "nuts_bolts.h"
 
 #include <avr/pgmspace.h>
+#include <util/crc16.h>
+
+#if defined(ENABLE_EEPROM_JOURNAL) && (PS_SETTINGS_NUM_PARAMETERS > 16)
+  #error "The EEPROM journal holds up to 16 product settings. See JOURNAL_KEY_PS_SETTING."
+#endif
 
 #define PS_SETTINGS_EEPROM_REVISION_OFFSET   0x1E
 #define PS_SETTINGS_EEPROM_PARAM_SIZE_OFFSET 0x1F
 #define PS_SETTINGS_EEPROM_PARAMETERS_OFFSET 0x20
 
-const ps_settings_map_element gCarvinParameterMap[] =
-{ // {Offset, Size, default value}
-  { 0U, 4U, 1.75f }, // Spindle Current Overload Threshold
+static const char name_spindle_i_max[] PROGMEM = "SpindleIMax";
+static const char name_auto_report_interval[] PROGMEM = "AutoReportInterval";
+static const char units_amps[] PROGMEM = "A";
+static const char name_sg_homing_threshold_x[] PROGMEM = "SGHomingThresholdX";
+static const char name_sg_homing_threshold_y[] PROGMEM = "SGHomingThresholdY";
+static const char name_sg_homing_threshold_z[] PROGMEM = "SGHomingThresholdZ";
+static const char name_sg_load_alarm[] PROGMEM = "SGLoadAlarm";
+static const char name_sg_load_action[] PROGMEM = "SGLoadAction";
+static const char units_ms[] PROGMEM = "ms";
+static const char units_none[] PROGMEM = "";
+
+const ps_settings_map_element gCarvinParameterMap[ PS_SETTINGS_NUM_PARAMETERS ] PROGMEM =
+{ // {name, units, type, default value, min, max}
+  { name_spindle_i_max, units_amps, PS_SETTINGS_TYPE_FLOAT, 1.75f, 0.0f, 3.0f },        // Spindle Current Overload Threshold
+  { name_auto_report_interval, units_ms, PS_SETTINGS_TYPE_FLOAT, 0.0f, 0.0f, 60000.0f }, // Status Auto Report Interval, 0 = disabled
+  { name_sg_homing_threshold_x, units_none, PS_SETTINGS_TYPE_UINT16, 0.0f, 0.0f, 1023.0f }, // StallGuard Homing Threshold X, 0 = switch
+  { name_sg_homing_threshold_y, units_none, PS_SETTINGS_TYPE_UINT16, 0.0f, 0.0f, 1023.0f }, // StallGuard Homing Threshold Y, 0 = switch
+  { name_sg_homing_threshold_z, units_none, PS_SETTINGS_TYPE_UINT16, 0.0f, 0.0f, 1023.0f }, // StallGuard Homing Threshold Z, 0 = switch
+  { name_sg_load_alarm, units_none, PS_SETTINGS_TYPE_UINT16, 0.0f, 0.0f, 1023.0f },         // Motor Load Stall Margin, 0 = disabled
+  { name_sg_load_action, units_none, PS_SETTINGS_TYPE_UINT8, 0.0f, 0.0f, 1.0f },            // Motor Load Stall Action, 0 = feed hold, 1 = alarm
 };
 
-static uint8_t* ps_settings_ram_storage = 0U;
-static const ps_settings_map_element* ps_settings_metadata = gCarvinParameterMap;
-static const char* ps_settings_header = "Inventables Settings          ";
+static uint8_t ps_settings_ram_storage[ PS_SETTINGS_STORAGE_MAX_SIZE ];
+static const char ps_settings_header[] PROGMEM = "Inventables Settings          ";
 static uint8_t storage_size = 0U;
+static volatile uint8_t generation = 0U;
 
 static void set_default_values( uint8_t* data );
 static void set_eeprom_storage_size( uint8_t size );
 static void set_eeprom_header_and_revision( void );
 static void write_ps_settings_to_eeprom( uint8_t* data, uint8_t data_size );
-static uint8_t validate_eeprom_image( const uint8_t* data );
+static void write_all_ps_settings( void );
+static uint8_t get_type_size( uint8_t type );
+static uint8_t get_size( uint8_t parameter );
+static uint8_t get_offset( uint8_t parameter );
+static void encode_value( uint8_t type, float value, uint8_t* data );
+static float decode_value( uint8_t type, const uint8_t* data );
+static uint8_t get_crc( const uint8_t* data, uint8_t size );
+static uint8_t read_ps_settings_from_eeprom( uint8_t data_size, uint8_t revision );
+#ifdef ENABLE_EEPROM_JOURNAL
+static void read_ps_settings_from_journal( void );
+#endif
 
 void ps_settings_init( void )
 {
-  uint8_t error = 0U;
+  uint8_t header[ PS_SETTINGS_EEPROM_PARAMETERS_OFFSET ];
+  uint8_t eeprom_data_size;
+  uint8_t eeprom_revision;
+  uint8_t element = 0U;
+  uint8_t valid = 0U;
+  
+  storage_size = 0U;
+  
+  for ( ; element < PS_SETTINGS_NUM_PARAMETERS; ++element )
+  {
+    storage_size += get_size( element );
+  }
+  
+  // set RAM storage to defaults    
+  set_default_values( ps_settings_ram_storage );
   
-  if ( PS_SETTINGS_NUM_PARAMETERS > 0 )
+  // recall from EEPROM
+  // header "Inventables Settings      ", revision and image size in one block
+  memcpy_from_eeprom_no_checksum( (char*)header, PS_SETTINGS_EEPROM_OFFSET, sizeof( header ) );
+  eeprom_revision = header[ PS_SETTINGS_EEPROM_REVISION_OFFSET ];
+  eeprom_data_size = header[ PS_SETTINGS_EEPROM_PARAM_SIZE_OFFSET ];
+  
+  if ( (eeprom_data_size > 0U) && 
+       (eeprom_data_size < 255U) &&
+       (memcmp_P( header, ps_settings_header, PS_SETTINGS_EEPROM_REVISION_OFFSET ) == 0 ) )
   {
-    uint8_t eeprom_data[ 256U ];
-    uint8_t eeprom_data_size = eeprom_get_char( PS_SETTINGS_EEPROM_OFFSET + PS_SETTINGS_EEPROM_PARAM_SIZE_OFFSET );
-    uint8_t eeprom_revision = eeprom_get_char( PS_SETTINGS_EEPROM_OFFSET + PS_SETTINGS_EEPROM_REVISION_OFFSET );
-    uint8_t eeprom_checksum = 0U;
-    uint8_t element = 0U;
+    valid = read_ps_settings_from_eeprom( eeprom_data_size, eeprom_revision );
+
+#ifdef ENABLE_EEPROM_JOURNAL
+    // single parameter changes are journaled on top of the image
+    read_ps_settings_from_journal();
+#endif
     
-    storage_size = 0U;
-        
-    for ( ; element < PS_SETTINGS_NUM_PARAMETERS; ++element )
+    if ( !valid ||
+         (eeprom_revision != PS_SETTINGS_VERSION) ||
+         (eeprom_data_size != storage_size) )
     {
-      storage_size += ps_settings_metadata[ element ].size;
+      // corrupted, older format, or more or less data than expected (downgrade/upgrade)
+      // --> rewrite the image in the current format, the revision last
+      set_eeprom_storage_size( storage_size );
+      write_ps_settings_to_eeprom( ps_settings_ram_storage, storage_size );
+      eeprom_put_char( PS_SETTINGS_EEPROM_OFFSET + PS_SETTINGS_EEPROM_REVISION_OFFSET, PS_SETTINGS_VERSION );
     }
-    
-    ps_settings_ram_storage = malloc( storage_size );
-    
-    // set RAM storage to defaults    
-    set_default_values( ps_settings_ram_storage );
-    
-    // recall from EEPROM
-    // header "Inventables Settings      "
-    memcpy_from_eeprom_no_checksum( eeprom_data,
-                                    PS_SETTINGS_EEPROM_OFFSET, 
-                                    30U );
-                                      
-    if ( (eeprom_data_size > 0U) && 
-         (eeprom_data_size < 255U) &&
-         (memcmp( ps_settings_header, eeprom_data, 30U ) == 0 ) )
-    {
-      eeprom_checksum = memcpy_from_eeprom_with_checksum( eeprom_data,
-                                                          PS_SETTINGS_EEPROM_OFFSET + PS_SETTINGS_EEPROM_PARAMETERS_OFFSET,
-                                                          eeprom_data_size );
-      if ( eeprom_checksum )
-      {
-        memcpy( ps_settings_ram_storage,
-                eeprom_data,
-                min( eeprom_data_size, storage_size ) );
-      }
-      
-      if ( eeprom_data_size != storage_size )
-      {
-        if ( eeprom_data_size > storage_size )
-        {
-          // more data than expected --> downgrade
-          set_eeprom_storage_size( storage_size );
-        }
-        else if ( eeprom_data_size < storage_size )
-        {
-          // less data than expected --> upgrade
-          set_eeprom_storage_size( storage_size );
-          write_ps_settings_to_eeprom( ps_settings_ram_storage, storage_size );
-        }
-      }
-    }
-    else
-    {
-      ps_settings_restore();
-    }    
   }
+  else
+  {
+    ps_settings_restore();
+  }    
+  
+  ++generation;
 }
 
 void ps_settings_restore( void )
@@ -107,55 +129,130 @@ void ps_settings_restore( void )
   set_eeprom_storage_size( storage_size );
   
   set_default_values( ps_settings_ram_storage );
+  ++generation;
   
-  write_ps_settings_to_eeprom( ps_settings_ram_storage, storage_size );
+  write_all_ps_settings();
 }
 
-uint8_t ps_settings_store_setting( uint8_t parameter, uint8_t* value )
+uint8_t ps_settings_get_element( uint8_t parameter, ps_settings_map_element* element )
 {
-  uint8_t success = 1U;
+  uint8_t result = PS_SETTINGS_INVALID_PARAMETER;
   
-  if ( parameter <= PS_SETTINGS_NUM_PARAMETERS )
+  if ( parameter < PS_SETTINGS_NUM_PARAMETERS )
   {
-    success = 0U; //(STATUS_OK)
-    memcpy( ps_settings_ram_storage + ps_settings_metadata[ parameter ].offset,
-            value,
-            ps_settings_metadata[ parameter ].size );
-            
-    write_ps_settings_to_eeprom( ps_settings_ram_storage, storage_size );
+    result = PS_SETTINGS_OK;
+    memcpy_P( element, &gCarvinParameterMap[ parameter ], sizeof( ps_settings_map_element ) );
   }
   
-  return success;
+  return result;
 }
 
-uint8_t ps_settings_get_setting( uint8_t parameter, uint8_t* value )
+uint8_t ps_settings_set_value( uint8_t parameter, float value )
 {
-  uint8_t success = 1U;
+  ps_settings_map_element element;
+  uint8_t result = ps_settings_get_element( parameter, &element );
   
-  if ( parameter < PS_SETTINGS_NUM_PARAMETERS )
+  if ( result == PS_SETTINGS_OK )
+  {
+    if ( !( (value >= element.min_value) && (value <= element.max_value) ) )  // also rejects NaN
+    {
+      result = PS_SETTINGS_OUT_OF_RANGE;
+    }
+    else
+    {
+      encode_value( element.type, value, ps_settings_ram_storage + get_offset( parameter ) );
+      ++generation;
+      
+#ifdef ENABLE_EEPROM_JOURNAL
+      // a single record instead of rewriting the whole image
+      journal_write( JOURNAL_KEY_PS_SETTING( parameter ),
+                     ps_settings_ram_storage + get_offset( parameter ),
+                     get_size( parameter ) );
+#else
+      write_ps_settings_to_eeprom( ps_settings_ram_storage, storage_size );
+#endif
+    }
+  }
+  
+  return result;
+}
+
+uint8_t ps_settings_get_generation( void )
+{
+  return generation;
+}
+
+uint8_t ps_settings_get_value( uint8_t parameter, float* value )
+{
+  ps_settings_map_element element;
+  uint8_t result = ps_settings_get_element( parameter, &element );
+  
+  if ( result == PS_SETTINGS_OK )
   {
-    if ( ps_settings_ram_storage )
+    *value = decode_value( element.type, ps_settings_ram_storage + get_offset( parameter ) );
+  }
+  else
+  {
+    result = PS_SETTINGS_INVALID_PARAMETER;
+  }
+  
+  return result;
+}
+
+uint8_t ps_settings_get_image_size( void )
+{
+  return storage_size + 2U;
+}
+
+void ps_settings_get_image( uint8_t* data )
+{
+  data[ 0 ] = PS_SETTINGS_NUM_PARAMETERS;
+  memcpy( &data[ 1 ], ps_settings_ram_storage, storage_size );
+  data[ storage_size + 1U ] = get_crc( data, storage_size + 1U );
+}
+
+uint8_t ps_settings_load_image( const uint8_t* data, uint8_t size )
+{
+  ps_settings_map_element element;
+  uint8_t parameter = 0U;
+  float value;
+  
+  if ( (size != storage_size + 2U) ||
+       (data[ 0 ] != PS_SETTINGS_NUM_PARAMETERS) ||
+       (data[ storage_size + 1U ] != get_crc( data, storage_size + 1U )) )
+  {
+    return PS_SETTINGS_INVALID_IMAGE;
+  }
+  data++;
+  
+  // validate everything before changing anything
+  for ( ; parameter < PS_SETTINGS_NUM_PARAMETERS; ++parameter )
+  {
+    ps_settings_get_element( parameter, &element );
+    value = decode_value( element.type, data + get_offset( parameter ) );
+    if ( !( (value >= element.min_value) && (value <= element.max_value) ) )  // also rejects NaN
     {
-      success = 0U; //(STATUS_OK)
-      memcpy( value, 
-              ps_settings_ram_storage + ps_settings_metadata[ parameter ].offset, 
-              ps_settings_metadata[ parameter ].size );
+      return PS_SETTINGS_OUT_OF_RANGE;
     }
   }
   
-  return success;
+  memcpy( ps_settings_ram_storage, data, storage_size );
+  ++generation;
+  
+  write_all_ps_settings();
+  
+  return PS_SETTINGS_OK;
 }
 
 void set_default_values( uint8_t* data )
 {
-  uint8_t element = 0U;
-  uint8_t size = 0U;
+  ps_settings_map_element element;
+  uint8_t parameter = 0U;
   
-  for ( ; element <= PS_SETTINGS_NUM_PARAMETERS; ++element )
+  for ( ; parameter < PS_SETTINGS_NUM_PARAMETERS; ++parameter )
   {
-    memcpy( &data[ ps_settings_metadata[ element ].offset ], 
-            &ps_settings_metadata[ element ].default_value.integer,
-            ps_settings_metadata[ element ].size );
+    ps_settings_get_element( parameter, &element );
+    encode_value( element.type, element.default_value, data + get_offset( parameter ) );
   }
 }
 
@@ -164,18 +261,190 @@ void set_eeprom_storage_size( uint8_t size )
   eeprom_put_char( PS_SETTINGS_EEPROM_OFFSET + PS_SETTINGS_EEPROM_PARAM_SIZE_OFFSET, size );  
 }
 
+/// Writes the image followed by its CRC-8
 void write_ps_settings_to_eeprom( uint8_t* data, uint8_t data_size )
 {
-  if ( data && data_size )
+  if ( data_size )
+  {
+    memcpy_to_eeprom_no_checksum( PS_SETTINGS_EEPROM_OFFSET + PS_SETTINGS_EEPROM_PARAMETERS_OFFSET,
+                                  (char*)data,
+                                  data_size );
+    eeprom_put_char( PS_SETTINGS_EEPROM_OFFSET + PS_SETTINGS_EEPROM_PARAMETERS_OFFSET + data_size,
+                     get_crc( data, data_size ) );
+  }
+}
+
+/// Reads and validates the stored image in one pass. Values beyond storage_size, stored by
+/// newer firmware, are validated and dropped. Revision 1 images carry the Grbl checksum.
+/// @return nonzero, if the image was valid and copied to the RAM storage
+uint8_t read_ps_settings_from_eeprom( uint8_t data_size, uint8_t revision )
+{
+  uint8_t data[ PS_SETTINGS_STORAGE_MAX_SIZE ];
+  unsigned int addr = PS_SETTINGS_EEPROM_OFFSET + PS_SETTINGS_EEPROM_PARAMETERS_OFFSET;
+  uint8_t crc = 0U;
+  uint8_t index = 0U;
+  uint8_t value;
+  
+  if ( revision == 1U )
+  {
+    // legacy images were never larger than the current one
+    if ( (data_size > sizeof( data )) ||
+         !memcpy_from_eeprom_with_checksum( (char*)data, addr, data_size ) )
+    {
+      return 0U;
+    }
+  }
+  else
+  {
+    for ( ; index < data_size; ++index )
+    {
+      value = eeprom_get_char( addr++ );
+      crc = _crc8_ccitt_update( crc, value );
+      if ( index < sizeof( data ) )
+      {
+        data[ index ] = value;
+      }
+    }
+    
+    if ( crc != eeprom_get_char( addr ) )
+    {
+      return 0U;
+    }
+  }
+  
+  memcpy( ps_settings_ram_storage, data, min( data_size, storage_size ) );
+  
+  return 1U;
+}
+
+void write_all_ps_settings( void )
+{
+  write_ps_settings_to_eeprom( ps_settings_ram_storage, storage_size );
+
+#ifdef ENABLE_EEPROM_JOURNAL
+  // journaled values would override the image on the next init
+  uint8_t element = 0U;
+  uint8_t value[ JOURNAL_DATA_SIZE ];
+
+  for ( ; element < PS_SETTINGS_NUM_PARAMETERS; ++element )
+  {
+    if ( journal_read( JOURNAL_KEY_PS_SETTING( element ), value, sizeof( value ) ) )
+    {
+      journal_write( JOURNAL_KEY_PS_SETTING( element ),
+                     ps_settings_ram_storage + get_offset( element ),
+                     get_size( element ) );
+    }
+  }
+#endif
+}
+
+uint8_t get_type_size( uint8_t type )
+{
+  switch ( type )
+  {
+    case PS_SETTINGS_TYPE_UINT8:
+    case PS_SETTINGS_TYPE_INT8:
+      return 1U;
+    case PS_SETTINGS_TYPE_UINT16:
+      return 2U;
+    default:
+      return 4U;
+  }
+}
+
+uint8_t get_size( uint8_t parameter )
+{
+  return get_type_size( pgm_read_byte( &gCarvinParameterMap[ parameter ].type ) );
+}
+
+/// The values are packed in parameter order, so the offset is the size of all preceding ones
+uint8_t get_offset( uint8_t parameter )
+{
+  uint8_t offset = 0U;
+  
+  while ( parameter > 0U )
+  {
+    offset += get_size( --parameter );
+  }
+  
+  return offset;
+}
+
+void encode_value( uint8_t type, float value, uint8_t* data )
+{
+  switch ( type )
+  {
+    case PS_SETTINGS_TYPE_UINT8:
+      *data = (uint8_t)lround( value );
+      break;
+    case PS_SETTINGS_TYPE_INT8:
+      *data = (uint8_t)(int8_t)lround( value );
+      break;
+    case PS_SETTINGS_TYPE_UINT16:
+    {
+      uint16_t integer = (uint16_t)lround( value );
+      memcpy( data, &integer, sizeof( integer ) );
+      break;
+    }
+    default:
+      memcpy( data, &value, sizeof( value ) );
+      break;
+  }
+}
+
+float decode_value( uint8_t type, const uint8_t* data )
+{
+  float value;
+  uint16_t integer;
+  
+  switch ( type )
   {
-    memcpy_to_eeprom_with_checksum( PS_SETTINGS_EEPROM_OFFSET + PS_SETTINGS_EEPROM_PARAMETERS_OFFSET,
-                                    data,
-                                    data_size );
+    case PS_SETTINGS_TYPE_UINT8:
+      return *data;
+    case PS_SETTINGS_TYPE_INT8:
+      return (int8_t)(*data);
+    case PS_SETTINGS_TYPE_UINT16:
+      memcpy( &integer, data, sizeof( integer ) );
+      return integer;
+    default:
+      memcpy( &value, data, sizeof( value ) );
+      return value;
   }
 }
 
+uint8_t get_crc( const uint8_t* data, uint8_t size )
+{
+  uint8_t crc = 0U;
+  
+  while ( size-- )
+  {
+    crc = _crc8_ccitt_update( crc, *data++ );
+  }
+  
+  return crc;
+}
+
 void set_eeprom_header_and_revision( void )
 {
-  memcpy_to_eeprom_no_checksum( PS_SETTINGS_EEPROM_OFFSET, ps_settings_header, 30U );
+  uint8_t index = 0U;
+  
+  for ( ; index < PS_SETTINGS_EEPROM_REVISION_OFFSET; ++index )
+  {
+    eeprom_put_char( PS_SETTINGS_EEPROM_OFFSET + index, pgm_read_byte( &ps_settings_header[ index ] ) );
+  }
   eeprom_put_char( PS_SETTINGS_EEPROM_OFFSET + PS_SETTINGS_EEPROM_REVISION_OFFSET, PS_SETTINGS_VERSION );
 }
+
+#ifdef ENABLE_EEPROM_JOURNAL
+void read_ps_settings_from_journal( void )
+{
+  uint8_t element = 0U;
+  
+  for ( ; element < PS_SETTINGS_NUM_PARAMETERS; ++element )
+  {
+    journal_read( JOURNAL_KEY_PS_SETTING( element ),
+                  ps_settings_ram_storage + get_offset( element ),
+                  get_size( element ) );
+  }
+}
+#endif
@@ -1,7 +1,7 @@
 /*
   ps_settings.h - Handles storing and retrieving product specific settings from
   Non Volatile Storage (EEPROM)
-  
+
   Copyright (c) 2017 Inventables Inc.
 */
 
@@ -10,45 +10,99 @@
 
 #include <stdint.h>
 
-#define PS_SETTINGS_VERSION 1U
+#define PS_SETTINGS_VERSION 2U  ///< 1: Grbl checksum, 2: CRC-8 after the image
 #define PS_SETTINGS_EEPROM_OFFSET 0x0800
-#define PS_SETTINGS_NUM_PARAMETERS (sizeof(gCarvinParameterMap)/sizeof(ps_settings_map_element))
+#define PS_SETTINGS_FIRST_ID 800U  ///< '$' number of parameter index 0
+
+/// Parameter indices. Index n is accessed as $(800+n). New parameters must be appended, since
+/// the EEPROM image packs the values in this order.
+#define PS_SETTING_SPINDLE_I_MAX         0U  ///< Spindle current overload threshold
+#define PS_SETTING_AUTO_REPORT_INTERVAL  1U  ///< Status auto report interval, 0 = disabled
+#define PS_SETTING_SG_HOMING_THRESHOLD_X 2U  ///< StallGuard homing stall threshold, 0 = home on the switch
+#define PS_SETTING_SG_HOMING_THRESHOLD_Y 3U  ///< Y and Z follow X, indexed by axis
+#define PS_SETTING_SG_HOMING_THRESHOLD_Z 4U
+#define PS_SETTING_SG_LOAD_ALARM         5U  ///< Motor load stall margin, as a StallGuard reading. 0 = disabled
+#define PS_SETTING_SG_LOAD_ACTION        6U  ///< Motor load stall action, 0 = feed hold, 1 = alarm
+#define PS_SETTINGS_NUM_PARAMETERS       7U
+
+/// RAM storage size. Allows for the largest type, so it's fixed at compile time
+#define PS_SETTINGS_STORAGE_MAX_SIZE (4U*PS_SETTINGS_NUM_PARAMETERS)
+
+/// Largest bulk image. Sized to fit a '$PL=' line in base64
+#define PS_SETTINGS_IMAGE_MAX_SIZE 54U
+
+#if ( PS_SETTINGS_STORAGE_MAX_SIZE + 2U > PS_SETTINGS_IMAGE_MAX_SIZE )
+  #error "PS_SETTINGS_IMAGE_MAX_SIZE too small for the settings storage and image header"
+#endif
+
+/// Parameter value types. Values are stored in EEPROM at the size of their type.
+#define PS_SETTINGS_TYPE_FLOAT  0U  ///< 4 bytes
+#define PS_SETTINGS_TYPE_UINT8  1U  ///< 1 byte
+#define PS_SETTINGS_TYPE_INT8   2U  ///< 1 byte
+#define PS_SETTINGS_TYPE_UINT16 3U  ///< 2 bytes
+
+/// Result codes
+#define PS_SETTINGS_OK                0U
+#define PS_SETTINGS_INVALID_PARAMETER 1U
+#define PS_SETTINGS_OUT_OF_RANGE      2U
+#define PS_SETTINGS_INVALID_IMAGE     3U
 
 typedef struct
 {
-  uint16_t offset;
-  uint16_t size;
-  union
-  {
-      float    real;
-      uint32_t integer;
-  } default_value;
+  const char* name;     ///< Parameter name, in program memory
+  const char* units;    ///< Units of the value, in program memory
+  uint8_t type;         ///< PS_SETTINGS_TYPE of the value
+  float default_value;
+  float min_value;
+  float max_value;
 } ps_settings_map_element;
 
+/// Parameter registry, in program memory
 extern const ps_settings_map_element gCarvinParameterMap[];
 
 /// Initializes the product specific settings subsystem
-/// Allocates and initializes a ps_settings_definition_t structure and storage
-/// @param[in] parameter_map A map of parameter to storage offset and size
+/// Loads and validates the stored image into the static RAM storage, or restores the defaults
 extern void ps_settings_init( void );
 
 /// Restore product specific NVS-backed settings to default
 extern void ps_settings_restore( void );
 
-/// Update the value and store a specific parameter in NVS
+/// Gets the registry entry of a parameter
+/// @param[in] parameter The parameter index
+/// @param[out] element A pointer to a RAM copy of the entry. name and units stay in program memory
+/// @return PS_SETTINGS_OK or PS_SETTINGS_INVALID_PARAMETER
+extern uint8_t ps_settings_get_element( uint8_t parameter, ps_settings_map_element* element );
+
+/// Validates, updates and stores a specific parameter in NVS
 /// @param[in] parameter The parameter index identifying which parameter to set
-/// @param[in] value A pointer to a RAM location storing the value to store
-/// @return success
-/// @retval 0 Sucessful operation (STATUS_OK)
-/// @retval 1 Unsuccessful operation
-extern uint8_t ps_settings_store_setting( uint8_t parameter, uint8_t* value );
+/// @param[in] value The new value. Rounded to the nearest integer for integer types
+/// @return PS_SETTINGS_OK, PS_SETTINGS_INVALID_PARAMETER or PS_SETTINGS_OUT_OF_RANGE
+extern uint8_t ps_settings_set_value( uint8_t parameter, float value );
+
+/// Gets the settings generation counter
+/// @note Incremented whenever any setting changes. Dependent modules compare it against the
+/// last value seen to recompute derived values once per change, instead of polling the settings.
+/// @return generation counter
+extern uint8_t ps_settings_get_generation( void );
 
 /// Gets a specified parameter value stored in NVS
 /// @param[in] The parameter index identifying which parameter to get
 /// @param[out] value A pointer to a RAM location to contain the value
-/// @return success
-/// @retval 0 Sucessful operation (STATUS_OK)
-/// @retval 1 Unsuccessful operation
-extern uint8_t ps_settings_get_setting( uint8_t parameter, uint8_t* value );
+/// @return PS_SETTINGS_OK or PS_SETTINGS_INVALID_PARAMETER
+extern uint8_t ps_settings_get_value( uint8_t parameter, float* value );
+
+/// Gets the size of the bulk image of all parameter values
+extern uint8_t ps_settings_get_image_size( void );
+
+/// Copies the bulk image of all parameter values, for provisioning other machines
+/// @note Layout: [number of parameters] [values, in parameter order at their type size] [CRC-8]
+/// @param[out] data A pointer to ps_settings_get_image_size() bytes of RAM
+extern void ps_settings_get_image( uint8_t* data );
+
+/// Validates a bulk image and all of its values, then stores them at once
+/// @param[in] data A bulk image, as returned by ps_settings_get_image
+/// @param[in] size The image size
+/// @return PS_SETTINGS_OK, PS_SETTINGS_INVALID_IMAGE or PS_SETTINGS_OUT_OF_RANGE
+extern uint8_t ps_settings_load_image( const uint8_t* data, uint8_t size );
 
 #endif
@@ -32,7 +32,7 @@
 // Internal report utilities to reduce flash with repetitive tasks turned into functions.
 void report_util_setting_prefix(uint8_t n) { serial_write('$'); print_uint8_base10(n); serial_write('='); }
 static void report_util_line_feed() { printPgmString(PSTR("\r\n")); }
-static void report_util_feedback_line_feed() { serial_write(']'); report_util_line_feed(); }
+void report_util_feedback_line_feed() { serial_write(']'); report_util_line_feed(); }
 static void report_util_gcode_modes_G() { printPgmString(PSTR(" G")); }
 static void report_util_gcode_modes_M() { printPgmString(PSTR(" M")); }
 // static void report_util_comment_line_feed() { serial_write(')'); report_util_line_feed(); }
@@ -229,11 +229,16 @@ void report_grbl_settings() {
   
 #ifdef CARVIN  
   {
-    float spindle_current_threshold = 0.0;
-    ps_settings_get_setting( 0, (uint8_t*)(&spindle_current_threshold) );
-    printPgmString(PSTR("$800="));
-    printFloat( spindle_current_threshold, N_DECIMAL_SETTINGVALUE );
-    report_util_line_feed();
+    float value = 0.0;
+    uint8_t parameter;
+    for (parameter=0; parameter<PS_SETTINGS_NUM_PARAMETERS; parameter++) {
+      ps_settings_get_value(parameter, &value);
+      serial_write('$');
+      print_uint32_base10(PS_SETTINGS_FIRST_ID+parameter);
+      serial_write('=');
+      printFloat(value, N_DECIMAL_SETTINGVALUE);
+      report_util_line_feed();
+    }
   }
 #endif
 }
@@ -383,6 +388,17 @@ void report_build_info(char *line)
     print_uint8_base10( (uint8_t)hardware_rev );
   #endif
   report_util_feedback_line_feed();
+  #ifdef CARVIN
+    // Boot time in msec and the stepper drivers that verified at configuration. [BOOT:<ms>:XYZ]
+    printPgmString(PSTR("[BOOT:"));
+    print_uint32_base10(carvin_boot_time_ms);
+    serial_write(':');
+    uint8_t idx;
+    for (idx=0; idx<N_AXIS; idx++) {
+      if (bit_istrue(tmc26x_ready_mask, bit(idx))) { serial_write("XYZ"[idx]); }
+    }
+    report_util_feedback_line_feed();
+  #endif
   printPgmString(PSTR("[OPT:")); // Generate compile-time build option list
   #ifdef VARIABLE_SPINDLE
     serial_write('V');
@@ -411,6 +427,18 @@ void report_build_info(char *line)
   #ifdef ALLOW_FEED_OVERRIDE_DURING_PROBE_CYCLES
     serial_write('A');
   #endif
+  #ifdef ENABLE_BINARY_MOTION_STREAM
+    serial_write('B');
+  #endif
+  #ifdef ENABLE_SEQUENCED_STREAM
+    serial_write('Q');
+  #endif
+  #ifdef ENABLE_COMPACT_STATUS_REPORT
+    serial_write('R');
+  #endif
+  #ifdef ENABLE_RT_LATENCY_STATS
+    serial_write('T');
+  #endif
   #ifndef ENABLE_RESTORE_EEPROM_WIPE_ALL // NOTE: Shown when disabled.
     serial_write('*');
   #endif
@@ -436,6 +464,51 @@ void report_build_info(char *line)
 }
 
 
+#ifdef CARVIN
+  // Prints a product settings registry entry and its value. Integer types print without decimals.
+  // [PS:<id>,<name>,<type>,<value>,<min>,<max>,<units>]
+  void report_ps_setting(uint8_t parameter)
+  {
+    ps_settings_map_element element;
+    float value = 0.0;
+    uint8_t n_decimal = 0;
+    if (ps_settings_get_element(parameter, &element) != PS_SETTINGS_OK) { return; }
+    ps_settings_get_value(parameter, &value);
+    printPgmString(PSTR("[PS:"));
+    print_uint32_base10(PS_SETTINGS_FIRST_ID+parameter);
+    serial_write(',');
+    printPgmString(element.name);
+    switch (element.type) {
+      case PS_SETTINGS_TYPE_UINT8: printPgmString(PSTR(",uint8,")); break;
+      case PS_SETTINGS_TYPE_INT8: printPgmString(PSTR(",int8,")); break;
+      case PS_SETTINGS_TYPE_UINT16: printPgmString(PSTR(",uint16,")); break;
+      default:
+        printPgmString(PSTR(",float,"));
+        n_decimal = N_DECIMAL_SETTINGVALUE;
+    }
+    printFloat(value, n_decimal);
+    serial_write(',');
+    printFloat(element.min_value, n_decimal);
+    serial_write(',');
+    printFloat(element.max_value, n_decimal);
+    serial_write(',');
+    printPgmString(element.units);
+    report_util_feedback_line_feed();
+  }
+
+
+  // Prints the bulk image of all product settings for provisioning. [PD:<base64 image>]
+  void report_ps_settings_image()
+  {
+    uint8_t image[PS_SETTINGS_IMAGE_MAX_SIZE];
+    ps_settings_get_image(image);
+    printPgmString(PSTR("[PD:"));
+    print_base64(image, ps_settings_get_image_size());
+    report_util_feedback_line_feed();
+  }
+#endif
+
+
 // Prints the character string line Grbl has received from the user, which has been pre-parsed,
 // and has been sent into protocol_execute_line() routine to be executed by Grbl.
 void report_echo_line_received(char *line)
@@ -450,13 +523,262 @@ void report_echo_line_received(char *line)
  // specific needs, but the desired real-time data report must be as short as possible. This is
  // requires as it minimizes the computational overhead and allows grbl to keep running smoothly,
  // especially during g-code programs with fast, short line segments and high frequency reports (5-20Hz).
+#ifdef ENABLE_RT_LATENCY_STATS
+  // Prints the realtime command latency statistics as '[RTL:<cmd>:<count>,<max usec>]' for each
+  // command type, in RT_LATENCY order '?!~JO', followed by the histogram as '[RTH:<bin counts>]'.
+  void report_rt_latency()
+  {
+    uint8_t idx;
+    for (idx=0; idx<RT_LATENCY_N_COMMANDS; idx++) {
+      printPgmString(PSTR("[RTL:"));
+      switch (idx) {
+        case RT_LATENCY_STATUS_REPORT: serial_write('?'); break;
+        case RT_LATENCY_FEED_HOLD: serial_write('!'); break;
+        case RT_LATENCY_CYCLE_START: serial_write('~'); break;
+        case RT_LATENCY_JOG_CANCEL: serial_write('J'); break;
+        case RT_LATENCY_OVERRIDE: serial_write('O'); break;
+      }
+      serial_write(':');
+      print_uint32_base10(sys_rt_latency.count[idx]);
+      serial_write(',');
+      print_uint32_base10(sys_rt_latency.max[idx]);
+      report_util_feedback_line_feed();
+    }
+    printPgmString(PSTR("[RTH:"));
+    for (idx=0; idx<RT_LATENCY_N_BINS; idx++) {
+      if (idx) { serial_write(','); }
+      print_uint32_base10(sys_rt_latency.histogram[idx]);
+    }
+    report_util_feedback_line_feed();
+  }
+#endif
+
+
+#ifdef ENABLE_COMPACT_STATUS_REPORT
+  // Values of the last compact status report. Only fields that differ from these are sent.
+  static int32_t csr_last_values[CSR_N_FIELDS][CSR_MAX_VALUES];
+
+  // Streaming base64 encoder of the compact report frame. Tracks the frame checksum.
+  static uint16_t csr_bit_buffer;
+  static uint8_t csr_bit_count;
+  static uint8_t csr_checksum;
+
+  static void csr_base64_write_char(uint8_t value)
+  {
+    if (value < 26) { serial_write('A'+value); }
+    else if (value < 52) { serial_write('a'+value-26); }
+    else if (value < 62) { serial_write('0'+value-52); }
+    else if (value == 62) { serial_write('+'); }
+    else { serial_write('/'); }
+  }
+
+  static void csr_base64_write_byte(uint8_t data)
+  {
+    csr_checksum ^= data;
+    csr_bit_buffer = (csr_bit_buffer << 8) | data;
+    csr_bit_count += 8;
+    while (csr_bit_count >= 6) {
+      csr_bit_count -= 6;
+      csr_base64_write_char((csr_bit_buffer >> csr_bit_count) & 0x3f);
+    }
+  }
+
+  // Writes a signed value as a zigzag varint. Small magnitudes take one byte.
+  static void csr_base64_write_varint(int32_t value)
+  {
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    while (zigzag > 0x7f) {
+      csr_base64_write_byte((zigzag & 0x7f) | 0x80);
+      zigzag >>= 7;
+    }
+    csr_base64_write_byte(zigzag);
+  }
+
+
+  // Prints the compact status report. Gathers all fields as integers, then sends only the ones
+  // that changed, or all of them upon a periodic refresh.
+  static void report_compact_status()
+  {
+    int32_t values[CSR_N_FIELDS][CSR_MAX_VALUES];
+    uint8_t n_values[CSR_N_FIELDS]; // Number of values per field. Zero, if not reported.
+    uint8_t idx;
+    memset(values, 0, sizeof(values));
+    memset(n_values, 0, sizeof(n_values));
+
+    // State and sub-state, coded like the Hold:/Door: report.
+    uint8_t state = sys.state;
+    uint8_t sub_state = 0;
+    if (state == STATE_HOLD) {
+      if (sys.suspend & SUSPEND_JOG_CANCEL) { state = STATE_JOG; }
+      else if (!(sys.suspend & SUSPEND_HOLD_COMPLETE)) { sub_state = 1; } // Actively holding
+    } else if (state == STATE_SAFETY_DOOR) {
+      if (sys.suspend & SUSPEND_INITIATE_RESTORE) { sub_state = 3; } // Restoring
+      else if (!(sys.suspend & SUSPEND_RETRACT_COMPLETE)) { sub_state = 2; } // Retracting
+      else if (sys.suspend & SUSPEND_SAFETY_DOOR_AJAR) { sub_state = 1; } // Door ajar
+    }
+    values[CSR_FIELD_STATE][0] = state;
+    values[CSR_FIELD_STATE][1] = sub_state;
+    n_values[CSR_FIELD_STATE] = 2;
+
+    memcpy(values[CSR_FIELD_POSITION], sys_position, sizeof(sys_position));
+    n_values[CSR_FIELD_POSITION] = N_AXIS;
+
+    #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+      float sys_wco_copy[N_AXIS];
+      system_get_wco(sys_wco_copy);
+    #endif
+    for (idx=0; idx<N_AXIS; idx++) {
+      #ifdef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+        float wco = gc_state.coord_system[idx]+gc_state.coord_offset[idx];
+        if (idx == TOOL_LENGTH_OFFSET_AXIS) { wco += gc_state.tool_length_offset; }
+      #else
+        float wco = sys_wco_copy[idx];
+      #endif
+      values[CSR_FIELD_WCO][idx] = lround(wco*settings.steps_per_mm[idx]);
+    }
+    n_values[CSR_FIELD_WCO] = N_AXIS;
+
+    #ifdef REPORT_FIELD_BUFFER_STATE
+      if (bit_istrue(settings.status_report_mask,BITFLAG_RT_STATUS_BUFFER_STATE)) {
+        values[CSR_FIELD_BUFFER][0] = plan_get_block_buffer_available();
+        values[CSR_FIELD_BUFFER][1] = serial_get_rx_buffer_available();
+        n_values[CSR_FIELD_BUFFER] = 2;
+      }
+    #endif
+
+    #ifdef USE_LINE_NUMBERS
+      #ifdef REPORT_FIELD_LINE_NUMBERS
+        plan_block_t * cur_block = plan_get_current_block();
+        if (cur_block != NULL) { values[CSR_FIELD_LINE_NUMBER][0] = cur_block->line_number; }
+        n_values[CSR_FIELD_LINE_NUMBER] = 1;
+      #endif
+    #endif
+
+    values[CSR_FIELD_FEED_SPEED][0] = lround(st_get_realtime_rate());
+    values[CSR_FIELD_FEED_SPEED][1] = lround(sys.spindle_speed);
+    n_values[CSR_FIELD_FEED_SPEED] = 2;
+
+    #ifdef CARVIN
+      if ( spindle_current_is_enabled() ) {
+        values[CSR_FIELD_CURRENT][0] = lround(1000.0*spindle_current_get());
+        n_values[CSR_FIELD_CURRENT] = 1;
+      }
+    #endif
+
+    #ifdef REPORT_FIELD_PIN_STATE
+      values[CSR_FIELD_PIN_STATE][0] = limits_get_state() | (system_control_get_state() << 4);
+      if (probe_get_state()) { values[CSR_FIELD_PIN_STATE][0] |= bit(3); }
+      n_values[CSR_FIELD_PIN_STATE] = 1;
+    #endif
+
+    #ifdef REPORT_FIELD_OVERRIDES
+      values[CSR_FIELD_OVERRIDES][0] = sys.f_override;
+      values[CSR_FIELD_OVERRIDES][1] = sys.r_override;
+      values[CSR_FIELD_OVERRIDES][2] = sys.spindle_speed_ovr;
+      n_values[CSR_FIELD_OVERRIDES] = 3;
+      values[CSR_FIELD_ACCESSORY][0] = spindle_get_state();
+      values[CSR_FIELD_ACCESSORY][1] = coolant_get_state();
+      n_values[CSR_FIELD_ACCESSORY] = 2;
+    #endif
+
+    #ifdef ENABLE_MOTOR_LOAD_TELEMETRY
+      if (bit_istrue(settings.status_report_mask,BITFLAG_RT_STATUS_MOTOR_LOAD)) {
+        uint16_t sg[N_AXIS];
+        carvin_get_motor_load(sg);
+        for (idx=0; idx<N_AXIS; idx++) { values[CSR_FIELD_MOTOR_LOAD][idx] = sg[idx]; }
+        n_values[CSR_FIELD_MOTOR_LOAD] = N_AXIS;
+      }
+    #endif
+
+    // Flag changed fields and remember them for the next report.
+    uint8_t refresh = false;
+    if (sys.report_compact_counter > 0) { sys.report_compact_counter--; }
+    else {
+      sys.report_compact_counter = (REPORT_COMPACT_REFRESH_COUNT-1);
+      refresh = true;
+    }
+    uint16_t field_mask = 0;
+    for (idx=0; idx<CSR_N_FIELDS; idx++) {
+      if (n_values[idx] == 0) { continue; }
+      if (refresh || memcmp(values[idx], csr_last_values[idx], n_values[idx]*sizeof(int32_t))) {
+        field_mask |= bit(idx);
+        memcpy(csr_last_values[idx], values[idx], n_values[idx]*sizeof(int32_t));
+      }
+    }
+
+    // NOTE: A frame is always sent, so every '?' gets a reply. With nothing changed, it is empty.
+    uint8_t val;
+    serial_write('{');
+    if (bit_istrue(settings.status_report_mask,BITFLAG_RT_STATUS_COMPACT_BASE64)) {
+      csr_bit_buffer = 0;
+      csr_bit_count = 0;
+      csr_checksum = 0;
+      csr_base64_write_byte(field_mask & 0xff);
+      csr_base64_write_byte(field_mask >> 8);
+      for (idx=0; idx<CSR_N_FIELDS; idx++) {
+        if (field_mask & bit(idx)) {
+          for (val=0; val<n_values[idx]; val++) { csr_base64_write_varint(values[idx][val]); }
+        }
+      }
+      csr_base64_write_byte(csr_checksum); // Zeroes the frame XOR.
+      if (csr_bit_count) { csr_base64_write_char((csr_bit_buffer << (6-csr_bit_count)) & 0x3f); }
+    } else {
+      uint8_t first = true;
+      for (idx=0; idx<CSR_N_FIELDS; idx++) {
+        if (bit_isfalse(field_mask,bit(idx))) { continue; }
+        if (!first) { serial_write('|'); }
+        first = false;
+        switch (idx) {
+          case CSR_FIELD_STATE: printPgmString(PSTR("St:")); break;
+          case CSR_FIELD_POSITION: printPgmString(PSTR("P:")); break;
+          case CSR_FIELD_WCO: printPgmString(PSTR("W:")); break;
+          case CSR_FIELD_BUFFER: printPgmString(PSTR("Bf:")); break;
+          case CSR_FIELD_LINE_NUMBER: printPgmString(PSTR("Ln:")); break;
+          case CSR_FIELD_FEED_SPEED: printPgmString(PSTR("FS:")); break;
+          case CSR_FIELD_CURRENT: printPgmString(PSTR("I:")); break;
+          case CSR_FIELD_PIN_STATE: printPgmString(PSTR("Pn:")); break;
+          case CSR_FIELD_OVERRIDES: printPgmString(PSTR("Ov:")); break;
+          case CSR_FIELD_ACCESSORY: printPgmString(PSTR("A:")); break;
+          case CSR_FIELD_MOTOR_LOAD: printPgmString(PSTR("SG:")); break;
+        }
+        for (val=0; val<n_values[idx]; val++) {
+          if (val) { serial_write(','); }
+          printInteger(values[idx][val]);
+        }
+      }
+    }
+    serial_write('}');
+    report_util_line_feed();
+  }
+#endif
+
+
 void report_realtime_status()
 {
+  #ifdef ENABLE_COMPACT_STATUS_REPORT
+    if (bit_istrue(settings.status_report_mask,BITFLAG_RT_STATUS_COMPACT)) {
+      report_compact_status();
+      return;
+    }
+  #endif
+
   uint8_t idx;
   int32_t current_position[N_AXIS]; // Copy current state of the system position variable
   memcpy(current_position,sys_position,sizeof(sys_position));
-  float print_position[N_AXIS];
-  system_convert_array_steps_to_mpos(print_position,current_position);
+  // Convert straight from steps to printed coordinate units. No float math or formatting.
+  int32_t print_position[N_AXIS];
+  for (idx=0; idx<N_AXIS; idx++) {
+    #ifdef COREXY
+      if (idx==X_AXIS) {
+        print_position[idx] = print_convert_steps_to_coord_units(system_convert_corexy_to_x_axis_steps(current_position), idx);
+        continue;
+      } else if (idx==Y_AXIS) {
+        print_position[idx] = print_convert_steps_to_coord_units(system_convert_corexy_to_y_axis_steps(current_position), idx);
+        continue;
+      }
+    #endif
+    print_position[idx] = print_convert_steps_to_coord_units(current_position[idx], idx);
+  }
 
   // Report current machine state and sub-states
   serial_write('<');
@@ -496,12 +818,18 @@ void report_realtime_status()
   float wco[N_AXIS];
   if (bit_isfalse(settings.status_report_mask,BITFLAG_RT_STATUS_POSITION_TYPE) ||
       (sys.report_wco_counter == 0) ) {
+    #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+      // Use the offset of the executing motion, which may lag the parser state.
+      system_get_wco(wco);
+    #endif
     for (idx=0; idx< N_AXIS; idx++) {
-      // Apply work coordinate offsets and tool length offset to current position.
-      wco[idx] = gc_state.coord_system[idx]+gc_state.coord_offset[idx];
-      if (idx == TOOL_LENGTH_OFFSET_AXIS) { wco[idx] += gc_state.tool_length_offset; }
+      #ifdef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+        // Apply work coordinate offsets and tool length offset to current position.
+        wco[idx] = gc_state.coord_system[idx]+gc_state.coord_offset[idx];
+        if (idx == TOOL_LENGTH_OFFSET_AXIS) { wco[idx] += gc_state.tool_length_offset; }
+      #endif
       if (bit_isfalse(settings.status_report_mask,BITFLAG_RT_STATUS_POSITION_TYPE)) {
-        print_position[idx] -= wco[idx];
+        print_position[idx] -= print_convert_mm_to_coord_units(wco[idx]);
       }
     }
   }
@@ -512,7 +840,10 @@ void report_realtime_status()
   } else {
     printPgmString(PSTR("|WPos:"));
   }
-  report_util_axis_values(print_position);
+  for (idx=0; idx<N_AXIS; idx++) {
+    printCoord_Units(print_position[idx]);
+    if (idx < (N_AXIS-1)) { serial_write(','); }
+  }
 
   // Returns planner and serial read buffer states.
   #ifdef REPORT_FIELD_BUFFER_STATE
@@ -520,7 +851,7 @@ void report_realtime_status()
       printPgmString(PSTR("|Bf:"));
       print_uint8_base10(plan_get_block_buffer_available());
       serial_write(',');
-      print_uint8_base10(serial_get_rx_buffer_available());
+      print_uint32_base10(serial_get_rx_buffer_available());
     }
   #endif
 
@@ -557,6 +888,18 @@ void report_realtime_status()
       printFloat(spindle_current_get(), 2);
     }
   #endif
+
+  #ifdef ENABLE_MOTOR_LOAD_TELEMETRY
+    if (bit_istrue(settings.status_report_mask,BITFLAG_RT_STATUS_MOTOR_LOAD)) {
+      uint16_t sg[N_AXIS];
+      carvin_get_motor_load(sg);
+      printPgmString(PSTR("|SG:"));
+      for (idx=0; idx<N_AXIS; idx++) {
+        if (idx) { serial_write(','); }
+        print_uint32_base10(sg[idx]);
+      }
+    }
+  #endif
   
   #ifdef REPORT_FIELD_PIN_STATE
     uint8_t lim_pin_state = limits_get_state();
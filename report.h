@@ -59,6 +59,10 @@
 #define STATUS_GCODE_G43_DYNAMIC_AXIS_ERROR 37
 #define STATUS_GCODE_MAX_VALUE_EXCEEDED 38
 
+#define STATUS_BINARY_FRAME_INVALID 50
+#define STATUS_SETTING_OUT_OF_RANGE 51
+#define STATUS_SETTING_IMAGE_INVALID 52
+
 // Define Grbl alarm codes. Valid values (1-255). 0 is reserved.
 #define ALARM_HARD_LIMIT_ERROR      EXEC_ALARM_HARD_LIMIT
 #define ALARM_SOFT_LIMIT_ERROR      EXEC_ALARM_SOFT_LIMIT
@@ -92,6 +96,9 @@ void report_alarm_message(uint8_t alarm_code);
 // Prints miscellaneous feedback messages.
 void report_feedback_message(uint8_t message_code);
 
+// Ends a '[...]' feedback line. For feedback printed outside of report.c.
+void report_util_feedback_line_feed();
+
 // Prints welcome message
 void report_init_message();
 
@@ -104,9 +111,42 @@ void report_grbl_settings();
 // Prints an echo of the pre-parsed line received right before execution.
 void report_echo_line_received(char *line);
 
+// Compact status report fields, in frame order. Enabled by the $10 status report mask. Each field
+// is a list of integers and is only sent when any of them changed since the last report. When no
+// field changed, an empty frame is sent: '{}' as text, or a zero field mask and checksum in base64.
+//   Text:   {St:8,0|P:1200,-800,-16|Bf:15,1020}
+//   Base64: {<frame>} where the decoded frame is [field mask (16-bit little-endian)]
+//           [zigzag varint values of each flagged field, in field order] [checksum]. The checksum
+//           is chosen such that the XOR of all frame bytes is zero. Standard base64 alphabet,
+//           unpadded, like binary motion frames.
+#define CSR_FIELD_STATE       0 // St: state bit flag (see STATE defines), sub-state as in Hold:/Door:
+#define CSR_FIELD_POSITION    1 // P: machine position in steps, N_AXIS values
+#define CSR_FIELD_WCO         2 // W: work coordinate offset in steps, N_AXIS values. WPos = P-W.
+#define CSR_FIELD_BUFFER      3 // Bf: planner blocks available, serial RX bytes available
+#define CSR_FIELD_LINE_NUMBER 4 // Ln: executing line number
+#define CSR_FIELD_FEED_SPEED  5 // FS: realtime feed rate (mm/min), spindle speed (rpm)
+#define CSR_FIELD_CURRENT     6 // I: spindle current (mA)
+#define CSR_FIELD_PIN_STATE   7 // Pn: limit axis bits, probe at bit 3, control pins from bit 4
+#define CSR_FIELD_OVERRIDES   8 // Ov: feed, rapid, and spindle speed overrides (%)
+#define CSR_FIELD_ACCESSORY   9 // A: spindle state, coolant state
+#define CSR_FIELD_MOTOR_LOAD  10 // SG: filtered StallGuard2 reading of each axis, N_AXIS values
+#define CSR_N_FIELDS          11
+#define CSR_MAX_VALUES        N_AXIS
+
 // Prints realtime status report
 void report_realtime_status();
 
+#ifdef CARVIN
+  // Prints a product settings registry entry and value, and the bulk image of all values.
+  void report_ps_setting(uint8_t parameter);
+  void report_ps_settings_image();
+#endif
+
+#ifdef ENABLE_RT_LATENCY_STATS
+  // Prints the realtime command latency statistics.
+  void report_rt_latency();
+#endif
+
 // Prints recorded probe position
 void report_probe_parameters();
 
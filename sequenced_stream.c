@@ -0,0 +1,209 @@
+/*
+  sequenced_stream.c - windowed acknowledgment streaming protocol
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  Sequenced stream mode is toggled by the '$A' system command and is cleared by a reset. Enabling
+  it restarts the sequence number at zero. While active, a line may be framed as:
+
+    ^<seq>:<line>*<checksum>
+
+    - seq: decimal line sequence number (0-255), incremented by one per line and wrapping to zero.
+    - line: the g-code block, '$' command, or binary motion frame. Must not contain a '*'.
+    - checksum: decimal XOR of all line bytes from the '^' up to, but not including, the '*'.
+
+  Lines without the '^' framing are executed and acknowledged with 'ok' or 'error:' as usual, so
+  interactive commands still work. Sequenced lines are acknowledged as follows:
+
+    ok:<seq>            All lines up to and including seq have been executed without error.
+                        Sent once SEQUENCED_STREAM_ACK_LINES are pending, or when the serial
+                        receive buffer runs empty. Lines are never acknowledged before executing.
+    error:<code>,<seq>  Line seq failed with the status code. Pending acks are sent before it.
+    rs:<seq>            Line seq was lost or corrupted. Resend all lines starting from it.
+
+  After a resend request, lines are discarded until line seq arrives intact. Retransmitted lines
+  that were already executed are discarded and re-acknowledged. A sender may keep as many lines in
+  flight as fit in the serial receive buffer, but fewer than 128, so sequence numbers are never
+  ambiguous.
+*/
+
+#include "grbl.h"
+
+#ifdef ENABLE_SEQUENCED_STREAM
+
+// Line framing parser states.
+#define SS_STATE_LINE_START 0 // No characters received yet.
+#define SS_STATE_PLAIN      1 // Line without framing. Executed as usual.
+#define SS_STATE_SEQ        2 // Receiving sequence number digits.
+#define SS_STATE_LINE       3 // Receiving line content.
+#define SS_STATE_CHECKSUM   4 // Receiving checksum digits.
+#define SS_STATE_INVALID    5 // Framing error. Discard remainder of line.
+
+typedef struct {
+  uint8_t state;         // Line framing parser state. See SS_STATE defines.
+  uint8_t checksum;      // Running XOR of the line bytes.
+  uint16_t seq;          // Received sequence number. 16-bit to detect out-of-range values.
+  uint16_t line_checksum; // Received checksum. 16-bit to detect out-of-range values.
+  uint8_t digits;        // Number of digits received in the current field.
+  uint8_t executing;     // Flags the executing line as sequenced. Cleared when reported.
+  uint8_t expected_seq;  // Sequence number of the next line to execute.
+  uint8_t ack_seq;       // Last executed line sequence number.
+  uint8_t ack_pending;   // Number of executed lines not yet acknowledged.
+  uint8_t resend;        // Flags a resend request is outstanding.
+} ss_t;
+static ss_t ss;
+
+
+void ss_reset()
+{
+  memset(&ss, 0, sizeof(ss_t));
+  ss.ack_seq = 0xff; // Nothing executed yet. Acknowledges as the line before zero.
+}
+
+
+// Accumulates a decimal digit into a framing field. Invalidates the line upon anything else.
+static void ss_read_digit(uint8_t c, uint16_t *value)
+{
+  if ((c < '0') || (c > '9') || (ss.digits == 3)) {
+    ss.state = SS_STATE_INVALID;
+  } else {
+    *value = 10*(*value) + (c-'0');
+    ss.digits++;
+  }
+}
+
+
+uint8_t ss_process_char(uint8_t c)
+{
+  switch (ss.state) {
+    case SS_STATE_LINE_START:
+      if (c != SS_LINE_START) {
+        ss.state = SS_STATE_PLAIN;
+        return(false);
+      }
+      ss.state = SS_STATE_SEQ;
+      ss.checksum = c;
+      ss.seq = 0;
+      ss.line_checksum = 0;
+      ss.digits = 0;
+      return(true);
+    case SS_STATE_PLAIN:
+      return(false);
+    case SS_STATE_SEQ:
+      ss.checksum ^= c;
+      if (c == SS_SEQ_END) {
+        if (ss.digits == 0) { ss.state = SS_STATE_INVALID; }
+        else {
+          ss.state = SS_STATE_LINE;
+          ss.digits = 0;
+        }
+      } else {
+        ss_read_digit(c, &ss.seq);
+      }
+      return(true);
+    case SS_STATE_LINE:
+      if (c == SS_CHECKSUM_START) {
+        ss.state = SS_STATE_CHECKSUM;
+        return(true);
+      }
+      ss.checksum ^= c;
+      return(false);
+    case SS_STATE_CHECKSUM:
+      ss_read_digit(c, &ss.line_checksum);
+      return(true);
+  }
+  return(true); // SS_STATE_INVALID
+}
+
+
+// Requests the sender to resend all lines starting from the expected line.
+static void ss_request_resend()
+{
+  ss_flush_ack();
+  printPgmString(PSTR("rs:"));
+  print_uint8_base10(ss.expected_seq);
+  printPgmString(PSTR("\r\n"));
+  ss.resend = true;
+}
+
+
+uint8_t ss_end_line()
+{
+  uint8_t state = ss.state;
+  ss.state = SS_STATE_LINE_START;
+  if ((state == SS_STATE_LINE_START) || (state == SS_STATE_PLAIN)) { return(true); }
+
+  if ((state != SS_STATE_CHECKSUM) || (ss.digits == 0) || (ss.seq > 255) ||
+      (ss.line_checksum != ss.checksum)) {
+    // Corrupted line. Its sequence number can't be trusted, so request the expected line.
+    ss_request_resend();
+    return(false);
+  }
+
+  uint8_t seq_ahead = (uint8_t)ss.seq - ss.expected_seq;
+  if (seq_ahead == 0) {
+    ss.expected_seq++;
+    ss.resend = false;
+    ss.executing = true;
+    return(true);
+  }
+  if (seq_ahead < 128) {
+    // Lines were lost. Request a resend once, then discard lines until the expected one arrives.
+    if (!ss.resend) { ss_request_resend(); }
+  } else {
+    // Retransmission of an executed line. Its acknowledgment may have been lost, so re-send it.
+    if (!ss.ack_pending) { ss.ack_pending = 1; }
+  }
+  return(false);
+}
+
+
+uint8_t ss_report_status(uint8_t status_code)
+{
+  if (!ss.executing) { return(false); }
+  ss.executing = false;
+  if (status_code == STATUS_OK) {
+    ss.ack_seq = ss.expected_seq-1;
+    ss.ack_pending++;
+    // Acknowledge right away, if the line disabled the mode, since no flush will follow it.
+    if ((ss.ack_pending >= SEQUENCED_STREAM_ACK_LINES) || !sys.sequenced_stream) { ss_flush_ack(); }
+  } else {
+    ss_flush_ack();
+    ss.ack_seq = ss.expected_seq-1;
+    printPgmString(PSTR("error:"));
+    print_uint8_base10(status_code);
+    serial_write(',');
+    print_uint8_base10(ss.ack_seq);
+    printPgmString(PSTR("\r\n"));
+  }
+  return(true);
+}
+
+
+void ss_flush_ack()
+{
+  if (ss.ack_pending) {
+    printPgmString(PSTR("ok:"));
+    print_uint8_base10(ss.ack_seq);
+    printPgmString(PSTR("\r\n"));
+    ss.ack_pending = 0;
+  }
+}
+
+#endif
@@ -0,0 +1,47 @@
+/*
+  sequenced_stream.h - windowed acknowledgment streaming protocol
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef sequenced_stream_h
+#define sequenced_stream_h
+
+// Sequenced line framing characters. See sequenced_stream.c for the protocol.
+#define SS_LINE_START    '^'
+#define SS_SEQ_END       ':'
+#define SS_CHECKSUM_START '*'
+
+// Restarts line sequencing at zero. Called when the sequenced stream mode is enabled.
+void ss_reset();
+
+// Processes one raw line character, before the line filtering. Returns true, if the character is
+// part of the sequence number or checksum framing and consumed. Otherwise, it's line content.
+uint8_t ss_process_char(uint8_t c);
+
+// Validates the framing of a completed line. Returns true, if the line is to be executed. A
+// corrupted or out-of-sequence line is discarded, and a resend is requested as needed.
+uint8_t ss_end_line();
+
+// Reports the execution status of the current line. Returns false, if it's not a sequenced line
+// and must be reported as usual.
+uint8_t ss_report_status(uint8_t status_code);
+
+// Sends the cumulative acknowledgment of all executed lines, if any are unacknowledged.
+void ss_flush_ack();
+
+#endif
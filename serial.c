@@ -24,56 +24,96 @@
 #define RX_RING_BUFFER (RX_BUFFER_SIZE+1)
 #define TX_RING_BUFFER (TX_BUFFER_SIZE+1)
 
+// NOTE: Ring buffer indices are 16-bit to allow for the large 2560 buffers. The AVR reads and writes
+// these in two instructions, so the main program accesses an index shared with a serial ISR with
+// interrupts disabled through the helpers below. The ISRs themselves can't be interrupted by the
+// main program and access them directly.
 uint8_t serial_rx_buffer[RX_RING_BUFFER];
-uint8_t serial_rx_buffer_head = 0;
-volatile uint8_t serial_rx_buffer_tail = 0;
+volatile uint16_t serial_rx_buffer_head = 0;
+volatile uint16_t serial_rx_buffer_tail = 0;
 
 uint8_t serial_tx_buffer[TX_RING_BUFFER];
-uint8_t serial_tx_buffer_head = 0;
-volatile uint8_t serial_tx_buffer_tail = 0;
+volatile uint16_t serial_tx_buffer_head = 0;
+volatile uint16_t serial_tx_buffer_tail = 0;
+
+// Line being assembled by serial_write(). Only accessed by the main program.
+static uint8_t serial_tx_line[TX_LINE_BUFFER_SIZE];
+static uint8_t serial_tx_line_count = 0;
+
+#ifdef ENABLE_BAUD_RATE_COMMAND
+  static uint32_t serial_baud_rate = 0; // Current baud rate. Zero until initialized.
+#endif
+
+
+// Atomically reads a ring buffer index updated by a serial ISR. Called by main program.
+static uint16_t serial_get_index(volatile uint16_t *index)
+{
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t value = *index;
+  SREG = sreg;
+  return(value);
+}
+
+
+// Atomically writes a ring buffer index read by a serial ISR. Called by main program.
+static void serial_set_index(volatile uint16_t *index, uint16_t value)
+{
+  uint8_t sreg = SREG;
+  cli();
+  *index = value;
+  SREG = sreg;
+}
 
 
 // Returns the number of bytes available in the RX serial buffer.
-uint8_t serial_get_rx_buffer_available()
+uint16_t serial_get_rx_buffer_available()
 {
-  uint8_t rtail = serial_rx_buffer_tail; // Copy to limit multiple calls to volatile
-  if (serial_rx_buffer_head >= rtail) { return(RX_BUFFER_SIZE - (serial_rx_buffer_head-rtail)); }
-  return((rtail-serial_rx_buffer_head-1));
+  uint16_t rhead = serial_get_index(&serial_rx_buffer_head);
+  uint16_t rtail = serial_rx_buffer_tail; // Only written by main program.
+  if (rhead >= rtail) { return(RX_BUFFER_SIZE - (rhead-rtail)); }
+  return((rtail-rhead-1));
 }
 
 
 // Returns the number of bytes used in the RX serial buffer.
 // NOTE: Deprecated. Not used unless classic status reports are enabled in config.h.
-uint8_t serial_get_rx_buffer_count()
+uint16_t serial_get_rx_buffer_count()
 {
-  uint8_t rtail = serial_rx_buffer_tail; // Copy to limit multiple calls to volatile
-  if (serial_rx_buffer_head >= rtail) { return(serial_rx_buffer_head-rtail); }
-  return (RX_BUFFER_SIZE - (rtail-serial_rx_buffer_head));
+  uint16_t rhead = serial_get_index(&serial_rx_buffer_head);
+  uint16_t rtail = serial_rx_buffer_tail; // Only written by main program.
+  if (rhead >= rtail) { return(rhead-rtail); }
+  return (RX_BUFFER_SIZE - (rtail-rhead));
 }
 
 
 // Returns the number of bytes used in the TX serial buffer.
 // NOTE: Not used except for debugging and ensuring no TX bottlenecks.
-uint8_t serial_get_tx_buffer_count()
+uint16_t serial_get_tx_buffer_count()
 {
-  uint8_t ttail = serial_tx_buffer_tail; // Copy to limit multiple calls to volatile
-  if (serial_tx_buffer_head >= ttail) { return(serial_tx_buffer_head-ttail); }
-  return (TX_RING_BUFFER - (ttail-serial_tx_buffer_head));
+  uint16_t ttail = serial_get_index(&serial_tx_buffer_tail);
+  uint16_t thead = serial_tx_buffer_head; // Only written by main program.
+  if (thead >= ttail) { return(thead-ttail); }
+  return (TX_RING_BUFFER - (ttail-thead));
 }
 
 
 void serial_init()
 {
   // Set baud rate
-  #if BAUD_RATE < 57600
-    uint16_t UBRR0_value = ((F_CPU / (8L * BAUD_RATE)) - 1)/2 ;
-    UCSR0A &= ~(1 << U2X0); // baud doubler off  - Only needed on Uno XXX
+  #ifdef ENABLE_BAUD_RATE_COMMAND
+    serial_set_baud_rate(BAUD_RATE);
   #else
-    uint16_t UBRR0_value = ((F_CPU / (4L * BAUD_RATE)) - 1)/2;
-    UCSR0A |= (1 << U2X0);  // baud doubler on for high baud rates, i.e. 115200
+    #if BAUD_RATE < 57600
+      uint16_t UBRR0_value = ((F_CPU / (8L * BAUD_RATE)) - 1)/2 ;
+      UCSR0A &= ~(1 << U2X0); // baud doubler off  - Only needed on Uno XXX
+    #else
+      uint16_t UBRR0_value = ((F_CPU / (4L * BAUD_RATE)) - 1)/2;
+      UCSR0A |= (1 << U2X0);  // baud doubler on for high baud rates, i.e. 115200
+    #endif
+    UBRR0H = UBRR0_value >> 8;
+    UBRR0L = UBRR0_value;
   #endif
-  UBRR0H = UBRR0_value >> 8;
-  UBRR0L = UBRR0_value;
 
   // enable rx, tx, and interrupt on complete reception of a byte
   UCSR0B |= (1<<RXEN0 | 1<<TXEN0 | 1<<RXCIE0);
@@ -82,31 +122,104 @@ void serial_init()
 }
 
 
-// Writes one byte to the TX serial buffer. Called by main program.
+#ifdef ENABLE_BAUD_RATE_COMMAND
+  // Sets the USART baud rate. Any pending output is completed at the current rate first, so
+  // the switch doesn't garble it. Called at power-up, upon a reset, and by the '$U' command.
+  void serial_set_baud_rate(uint32_t baud_rate)
+  {
+    if (baud_rate == serial_baud_rate) { return; }
+    if (serial_baud_rate) {
+      serial_flush();
+      // Wait for the TX buffer to empty and allow the last character to shift out.
+      while (serial_tx_buffer_head != serial_get_index(&serial_tx_buffer_tail)) {
+        if (sys_rt_exec_state & EXEC_RESET) { break; }
+      }
+      delay_us(10000000/serial_baud_rate + 1); // Ten bit times per character.
+    }
+
+    uint16_t UBRR0_value;
+    if (baud_rate < 57600) {
+      UBRR0_value = ((F_CPU / (8L * baud_rate)) - 1)/2 ;
+      UCSR0A &= ~(1 << U2X0); // baud doubler off  - Only needed on Uno XXX
+    } else {
+      UBRR0_value = ((F_CPU / (4L * baud_rate)) - 1)/2;
+      UCSR0A |= (1 << U2X0);  // baud doubler on for high baud rates, i.e. 115200
+    }
+    UBRR0H = UBRR0_value >> 8;
+    UBRR0L = UBRR0_value;
+    serial_baud_rate = baud_rate;
+  }
+
+
+  // Switches to a new baud rate, after the '$U' command 'ok' is sent, and waits for the host to
+  // confirm the link with a '?' status report request at the new rate. The request is left set
+  // for the main loop to answer as usual. Falls back to BAUD_RATE, if the host doesn't confirm.
+  void serial_negotiate_baud_rate(uint32_t baud_rate)
+  {
+    serial_set_baud_rate(baud_rate);
+    serial_reset_read_buffer(); // Discard anything garbled by the switch.
+    system_clear_exec_state_flag(EXEC_STATUS_REPORT);
+    uint16_t timeout = BAUD_RATE_HANDSHAKE_TIMEOUT;
+    while (bit_isfalse(sys_rt_exec_state,EXEC_STATUS_REPORT)) {
+      if (sys_rt_exec_state & EXEC_RESET) { return; } // Reset falls back to BAUD_RATE anyhow.
+      if (timeout-- == 0) {
+        serial_set_baud_rate(BAUD_RATE);
+        serial_reset_read_buffer();
+        return;
+      }
+      delay_ms(1);
+    }
+  }
+#endif
+
+
+// Writes one byte to the TX line buffer. Called by main program.
 void serial_write(uint8_t data) {
-  // Calculate next head
-  uint8_t next_head = serial_tx_buffer_head + 1;
-  if (next_head == TX_RING_BUFFER) { next_head = 0; }
-
-  // Wait until there is space in the buffer
-  while (next_head == serial_tx_buffer_tail) {
-    // TODO: Restructure st_prep_buffer() calls to be executed here during a long print.
-    if (sys_rt_exec_state & EXEC_RESET) { return; } // Only check for abort to avoid an endless loop.
+  serial_tx_line[serial_tx_line_count++] = data;
+  if ((data == '\n') || (serial_tx_line_count == TX_LINE_BUFFER_SIZE)) { serial_flush(); }
+}
+
+
+// Copies the TX line buffer into the TX serial buffer. Space for the whole line is reserved once,
+// the bytes are copied, and the head is advanced with a single interrupt enable, rather than
+// handshaking with the TX ISR for every character. Called by main program.
+void serial_flush() {
+  uint8_t count = serial_tx_line_count;
+  if (count == 0) { return; }
+  serial_tx_line_count = 0;
+
+  // Wait until there is space for the line. Keep the step segment buffer fed while waiting, so
+  // long prints during motion, like a '$$' dump or verbose status reports, can't starve it.
+  // NOTE: Other realtime commands are executed after the print, since report routines aren't
+  // re-entrant. Only the abort is checked here to avoid an endless loop.
+  while ((TX_BUFFER_SIZE-serial_get_tx_buffer_count()) < count) {
+    if (sys_rt_exec_state & EXEC_RESET) { return; }
+    if ((SREG & (1<<SREG_I)) && (sys.state & (STATE_CYCLE | STATE_HOLD | STATE_SAFETY_DOOR | STATE_JOG))) {
+      st_prep_buffer();
+    }
   }
 
-  // Store data and advance head
-  serial_tx_buffer[serial_tx_buffer_head] = data;
-  serial_tx_buffer_head = next_head;
+  // Copy the line. The TX ISR doesn't touch the free space ahead of the head.
+  uint16_t head = serial_tx_buffer_head;
+  uint8_t idx;
+  for (idx=0; idx<count; idx++) {
+    serial_tx_buffer[head++] = serial_tx_line[idx];
+    if (head == TX_RING_BUFFER) { head = 0; }
+  }
 
-  // Enable Data Register Empty Interrupt to make sure tx-streaming is running
+  // Publish the line and enable Data Register Empty Interrupt to make sure tx-streaming is running
+  uint8_t sreg = SREG;
+  cli();
+  serial_tx_buffer_head = head;
   UCSR0B |=  (1 << UDRIE0);
+  SREG = sreg;
 }
 
 
 // Data Register Empty Interrupt handler
 ISR(SERIAL_UDRE)
 {
-  uint8_t tail = serial_tx_buffer_tail; // Temporary serial_tx_buffer_tail (to optimize for volatile)
+  uint16_t tail = serial_tx_buffer_tail; // Temporary serial_tx_buffer_tail (to optimize for volatile)
 
   // Send a byte from the buffer
   UDR0 = serial_tx_buffer[tail];
@@ -125,15 +238,15 @@ ISR(SERIAL_UDRE)
 // Fetches the first byte in the serial read buffer. Called by main program.
 uint8_t serial_read()
 {
-  uint8_t tail = serial_rx_buffer_tail; // Temporary serial_rx_buffer_tail (to optimize for volatile)
-  if (serial_rx_buffer_head == tail) {
+  uint16_t tail = serial_rx_buffer_tail; // Temporary serial_rx_buffer_tail (to optimize for volatile)
+  if (serial_get_index(&serial_rx_buffer_head) == tail) {
     return SERIAL_NO_DATA;
   } else {
     uint8_t data = serial_rx_buffer[tail];
 
     tail++;
     if (tail == RX_RING_BUFFER) { tail = 0; }
-    serial_rx_buffer_tail = tail;
+    serial_set_index(&serial_rx_buffer_tail, tail);
 
     return data;
   }
@@ -143,7 +256,11 @@ uint8_t serial_read()
 ISR(SERIAL_RX)
 {
   uint8_t data = UDR0;
-  uint8_t next_head;
+  uint16_t next_head;
+
+  #ifdef ENABLE_RT_LATENCY_STATS
+    system_rt_latency_start(data);
+  #endif
 
   // Pick off realtime command characters directly from the serial stream. These characters are
   // not passed into the main buffer, but these set system state flag bits for realtime execution.
@@ -210,5 +327,5 @@ ISR(SERIAL_RX)
 
 void serial_reset_read_buffer()
 {
-  serial_rx_buffer_tail = serial_rx_buffer_head;
+  serial_set_index(&serial_rx_buffer_tail, serial_get_index(&serial_rx_buffer_head));
 }
@@ -23,15 +23,23 @@
 #define serial_h
 
 
+// NOTE: Sized for the 8KB SRAM of the 2560. Ring buffer indices are 16-bit.
 #ifndef RX_BUFFER_SIZE
-  #define RX_BUFFER_SIZE 128
+  #define RX_BUFFER_SIZE 1024
 #endif
 #ifndef TX_BUFFER_SIZE
-  #ifdef USE_LINE_NUMBERS
-    #define TX_BUFFER_SIZE 112
-  #else
-    #define TX_BUFFER_SIZE 104
-  #endif
+  #define TX_BUFFER_SIZE 256
+#endif
+// Output is assembled a line at a time, then copied into the TX buffer in one burst. Sized to hold
+// a worst-case status report.
+#ifndef TX_LINE_BUFFER_SIZE
+  #define TX_LINE_BUFFER_SIZE 128
+#endif
+#if (TX_LINE_BUFFER_SIZE > TX_BUFFER_SIZE)
+  #error "TX_LINE_BUFFER_SIZE must not exceed TX_BUFFER_SIZE, or a full line never fits in the TX buffer."
+#endif
+#if (TX_LINE_BUFFER_SIZE > 255)
+  #error "TX_LINE_BUFFER_SIZE must be 255 or less. Its count is 8-bit."
 #endif
 
 #define SERIAL_NO_DATA 0xff
@@ -39,9 +47,21 @@
 
 void serial_init();
 
-// Writes one byte to the TX serial buffer. Called by main program.
+#ifdef ENABLE_BAUD_RATE_COMMAND
+  // Sets the USART baud rate, after completing any pending output at the current rate.
+  void serial_set_baud_rate(uint32_t baud_rate);
+
+  // Switches to a new baud rate and waits for the host to confirm it. Falls back to BAUD_RATE.
+  void serial_negotiate_baud_rate(uint32_t baud_rate);
+#endif
+
+// Writes one byte to the TX line buffer. The line is sent upon a line feed or when the line buffer
+// fills. Called by main program only. Never print from an interrupt.
 void serial_write(uint8_t data);
 
+// Sends any partial line in the TX line buffer. Called by main program.
+void serial_flush();
+
 // Fetches the first byte in the serial read buffer. Called by main program.
 uint8_t serial_read();
 
@@ -49,14 +69,14 @@ uint8_t serial_read();
 void serial_reset_read_buffer();
 
 // Returns the number of bytes available in the RX serial buffer.
-uint8_t serial_get_rx_buffer_available();
+uint16_t serial_get_rx_buffer_available();
 
 // Returns the number of bytes used in the RX serial buffer.
 // NOTE: Deprecated. Not used unless classic status reports are enabled in config.h.
-uint8_t serial_get_rx_buffer_count();
+uint16_t serial_get_rx_buffer_count();
 
 // Returns the number of bytes used in the TX serial buffer.
 // NOTE: Not used except for debugging and ensuring no TX bottlenecks.
-uint8_t serial_get_tx_buffer_count();
+uint16_t serial_get_tx_buffer_count();
 
 #endif
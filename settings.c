@@ -23,6 +23,14 @@
 
 settings_t settings;
 
+// RAM copies of the coordinate data and startup lines. Loaded once by settings_init() and kept
+// current by the write methods, so g-code reads like a G54-G59 selection never touch the EEPROM.
+// Records with a bad checksum at load time are flagged, so their first read still reports it.
+static float coord_data_cache[SETTING_INDEX_NCOORD+1][N_AXIS];
+static char startup_line_cache[N_STARTUP_LINE][LINE_BUFFER_SIZE];
+static uint8_t coord_data_read_fail; // Bitflags by coord_select.
+static uint8_t startup_line_read_fail; // Bitflags by startup line number.
+
 
 // Method to store startup lines into EEPROM
 void settings_store_startup_line(uint8_t n, char *line)
@@ -31,6 +39,7 @@ void settings_store_startup_line(uint8_t n, char *line)
     protocol_buffer_synchronize(); // A startup line may contain a motion and be executing. 
   #endif
   uint32_t addr = n*(LINE_BUFFER_SIZE+1)+EEPROM_ADDR_STARTUP_BLOCK;
+  memcpy(startup_line_cache[n], line, LINE_BUFFER_SIZE);
   memcpy_to_eeprom_with_checksum(addr,(char*)line, LINE_BUFFER_SIZE);
 }
 
@@ -50,8 +59,13 @@ void settings_write_coord_data(uint8_t coord_select, float *coord_data)
   #ifdef FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE
     protocol_buffer_synchronize();
   #endif
-  uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
-  memcpy_to_eeprom_with_checksum(addr,(char*)coord_data, sizeof(float)*N_AXIS);
+  memcpy(coord_data_cache[coord_select], coord_data, sizeof(float)*N_AXIS);
+  #ifdef ENABLE_EEPROM_JOURNAL
+    journal_write(JOURNAL_KEY_COORD(coord_select), (uint8_t*)coord_data, sizeof(float)*N_AXIS);
+  #else
+    uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
+    memcpy_to_eeprom_with_checksum(addr,(char*)coord_data, sizeof(float)*N_AXIS);
+  #endif
 }
 
 
@@ -108,6 +122,7 @@ void settings_restore(uint8_t restore_flag) {
     settings.max_travel[Z_AXIS] = (-DEFAULT_Z_MAX_TRAVEL);
 
     write_global_settings();
+    print_coord_scale_init();
     
     #ifdef CARVIN
       ps_settings_restore();
@@ -146,6 +161,9 @@ void settings_restore(uint8_t restore_flag) {
       eeprom_put_char(EEPROM_ADDR_STARTUP_BLOCK+(LINE_BUFFER_SIZE+1), 0);
       eeprom_put_char(EEPROM_ADDR_STARTUP_BLOCK+(LINE_BUFFER_SIZE+2), 0); // Checksum
     #endif
+    uint8_t n;
+    for (n=0; n < N_STARTUP_LINE; n++) { startup_line_cache[n][0] = 0; } // Keep the cache in sync.
+    startup_line_read_fail = 0;
   }
 
   if (restore_flag & SETTINGS_RESTORE_BUILD_INFO) {
@@ -155,14 +173,12 @@ void settings_restore(uint8_t restore_flag) {
 }
 
 
-// Reads startup line from EEPROM. Updated pointed line string data.
+// Reads startup line from the RAM cache. Updated pointed line string data.
 uint8_t settings_read_startup_line(uint8_t n, char *line)
 {
-  uint32_t addr = n*(LINE_BUFFER_SIZE+1)+EEPROM_ADDR_STARTUP_BLOCK;
-  if (!(memcpy_from_eeprom_with_checksum((char*)line, addr, LINE_BUFFER_SIZE))) {
-    // Reset line with default value
-    line[0] = 0; // Empty line
-    settings_store_startup_line(n, line);
+  memcpy(line, startup_line_cache[n], LINE_BUFFER_SIZE);
+  if (bit_istrue(startup_line_read_fail,bit(n))) {
+    startup_line_read_fail &= ~bit(n);
     return(false);
   }
   return(true);
@@ -182,20 +198,60 @@ uint8_t settings_read_build_info(char *line)
 }
 
 
-// Read selected coordinate data from EEPROM. Updates pointed coord_data value.
+// Read selected coordinate data from the RAM cache. Updates pointed coord_data value.
 uint8_t settings_read_coord_data(uint8_t coord_select, float *coord_data)
 {
-  uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
-  if (!(memcpy_from_eeprom_with_checksum((char*)coord_data, addr, sizeof(float)*N_AXIS))) {
-    // Reset with default zero vector
-    clear_vector_float(coord_data);
-    settings_write_coord_data(coord_select,coord_data);
+  memcpy(coord_data, coord_data_cache[coord_select], sizeof(float)*N_AXIS);
+  if (bit_istrue(coord_data_read_fail,bit(coord_select))) {
+    coord_data_read_fail &= ~bit(coord_select);
     return(false);
   }
   return(true);
 }
 
 
+// Loads the coordinate data and startup lines from EEPROM into the RAM cache. Records failing the
+// checksum are reset to defaults in both, and flagged for their next read. Coordinate data not yet
+// in the journal is loaded from its fixed address, where older firmware stored it.
+static void settings_load_cache()
+{
+  uint8_t idx;
+  uint32_t addr;
+  float coord_data[N_AXIS];
+  char line[LINE_BUFFER_SIZE];
+  coord_data_read_fail = 0;
+  for (idx=0; idx <= SETTING_INDEX_NCOORD; idx++) {
+    #ifdef ENABLE_EEPROM_JOURNAL
+      if (journal_read(JOURNAL_KEY_COORD(idx), (uint8_t*)coord_data, sizeof(coord_data))) {
+        memcpy(coord_data_cache[idx], coord_data, sizeof(coord_data));
+        continue;
+      }
+    #endif
+    addr = idx*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
+    if (!(memcpy_from_eeprom_with_checksum((char*)coord_data, addr, sizeof(float)*N_AXIS))) {
+      // Reset with default zero vector
+      clear_vector_float(coord_data);
+      settings_write_coord_data(idx,coord_data);
+      coord_data_read_fail |= bit(idx);
+    } else {
+      memcpy(coord_data_cache[idx], coord_data, sizeof(coord_data));
+    }
+  }
+  startup_line_read_fail = 0;
+  for (idx=0; idx < N_STARTUP_LINE; idx++) {
+    addr = idx*(LINE_BUFFER_SIZE+1)+EEPROM_ADDR_STARTUP_BLOCK;
+    if (!(memcpy_from_eeprom_with_checksum(line, addr, LINE_BUFFER_SIZE))) {
+      // Reset line with default value
+      line[0] = 0; // Empty line
+      settings_store_startup_line(idx, line);
+      startup_line_read_fail |= bit(idx);
+    } else {
+      memcpy(startup_line_cache[idx], line, LINE_BUFFER_SIZE);
+    }
+  }
+}
+
+
 // Reads Grbl global settings struct from EEPROM.
 uint8_t read_global_settings() {
   // Check version-byte of eeprom
@@ -255,6 +311,7 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
               if (value*settings.max_rate[parameter] > (MAX_STEP_RATE_HZ*60.0)) { return(STATUS_MAX_STEP_RATE_EXCEEDED); }
             #endif
             settings.steps_per_mm[parameter] = value;
+            print_coord_scale_init();
             break;
           case 1:
             #ifdef MAX_STEP_RATE_HZ
@@ -309,6 +366,7 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
         if (int_value) { settings.flags |= BITFLAG_REPORT_INCHES; }
         else { settings.flags &= ~BITFLAG_REPORT_INCHES; }
         system_flag_wco_change(); // Make sure WCO is immediately updated.
+        print_coord_scale_init();
         break;
       case 20:
         if (int_value) {
@@ -354,11 +412,16 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
 
 // Initialize the config subsystem
 void settings_init() {
+  #ifdef ENABLE_EEPROM_JOURNAL
+    journal_init(); // Before any coordinate data is restored or loaded.
+  #endif
   if(!read_global_settings()) {
     report_status_message(STATUS_SETTING_READ_FAIL);
     settings_restore(SETTINGS_RESTORE_ALL); // Force restore all EEPROM data.
     report_grbl_settings();
   }
+  settings_load_cache();
+  print_coord_scale_init();
 }
 
 
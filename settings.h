@@ -42,6 +42,9 @@
 // Define status reporting boolean enable bit flags in settings.status_report_mask
 #define BITFLAG_RT_STATUS_POSITION_TYPE     bit(0)
 #define BITFLAG_RT_STATUS_BUFFER_STATE      bit(1)
+#define BITFLAG_RT_STATUS_COMPACT           bit(2) // Compact delta report. See report.h.
+#define BITFLAG_RT_STATUS_COMPACT_BASE64    bit(3) // Base64 framing of the compact report.
+#define BITFLAG_RT_STATUS_MOTOR_LOAD        bit(4) // SG: motor load field. Carvin only.
 
 // Define settings restore bitflags.
 #define SETTINGS_RESTORE_DEFAULTS bit(0)
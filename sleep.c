@@ -63,7 +63,7 @@ ISR(TIMER3_OVF_vect) { sleep_counter++; }
 static void sleep_execute()
 {
   // Fetch current number of buffered characters in serial RX buffer.
-  uint8_t rx_initial = serial_get_rx_buffer_count();
+  uint16_t rx_initial = serial_get_rx_buffer_count();
 
   // Enable sleep counter
   sleep_enable();
@@ -97,7 +97,8 @@ void sleep_check()
   // to directly monitor and record running state during parking to ensure proper function.
   if (gc_state.modal.spindle || gc_state.modal.coolant) {
     if (sys.state == STATE_IDLE) { 
-      sleep_execute();
+      // NOTE: Program mode may hold queued motions in IDLE until there are enough to start.
+      if (plan_get_current_block() == NULL) { sleep_execute(); }
     } else if ((sys.state & STATE_HOLD) && (sys.suspend & SUSPEND_HOLD_COMPLETE)) {
       sleep_execute();
     } else if (sys.state == STATE_SAFETY_DOOR && (sys.suspend & SUSPEND_RETRACT_COMPLETE)) {
@@ -11,6 +11,26 @@
 #define DD_SCK      DDB1
 #define DD_SS       DDB0
 
+#define SPI_DATAGRAM_BYTES 3  // 20 bit datagrams go out as 24 bits, the chips keep the last 20
+
+// Queue of datagrams waiting to be sent, drained by the SPI transfer complete interrupt. The job
+// at the tail is the one being shifted out.
+typedef struct {
+  unsigned long datagram;
+  volatile uint8_t *cs_port;
+  uint8_t cs_bit;
+  spi_callback_t callback;
+} spi_job_t;
+
+static spi_job_t spi_queue[SPI_QUEUE_SIZE];
+static volatile uint8_t spi_queue_head = 0;
+static volatile uint8_t spi_queue_tail = 0;
+static uint8_t spi_byte_count;          // bytes of the current job shifted out
+static unsigned long spi_response;      // response of the current job, shifted in so far
+
+static volatile uint8_t spi_sync_done;  // spi_send20bit() completion
+static volatile unsigned long spi_sync_response;
+
 
 void spi_init()
 // Initialize pins for spi communication
@@ -32,8 +52,58 @@ void spi_init()
 }
 
 
+static uint8_t spi_queue_next(uint8_t index)
+{
+  if (++index == SPI_QUEUE_SIZE) { index = 0; }
+  return index;
+}
+
+
+// Selects the chip of the job at the tail and starts shifting out its first byte.
+// Must be called with interrupts disabled.
+static void spi_start_job()
+{
+  spi_job_t *job = &spi_queue[spi_queue_tail];
+  spi_byte_count = 0;
+  spi_response = 0;
+  *job->cs_port &= ~(1<<job->cs_bit);  // chip select
+  SPCR |= (1<<SPIE);
+  SPDR = (job->datagram >> 16) & 0xff;
+}
+
+
+// A byte finished shifting. Sends the next byte of the job, or completes it and starts the next one.
+// Must be called with interrupts disabled.
+static void spi_transfer_complete()
+{
+  spi_job_t *job = &spi_queue[spi_queue_tail];
+  spi_response = (spi_response << 8) | SPDR;
+  if (++spi_byte_count < SPI_DATAGRAM_BYTES) {
+    SPDR = (job->datagram >> (8*(SPI_DATAGRAM_BYTES-1-spi_byte_count))) & 0xff;
+    return;
+  }
+  *job->cs_port |= (1<<job->cs_bit);  // deselect chip
+  if (job->callback) { job->callback(job->cs_bit, spi_response >> 4); }
+  spi_queue_tail = spi_queue_next(spi_queue_tail);
+  if (spi_queue_tail == spi_queue_head) {
+    SPCR &= ~(1<<SPIE);  // Queue empty. Stop the interrupt.
+  } else {
+    spi_start_job();
+  }
+}
+
+
+// Polls the transfer in progress to completion. For use with interrupts disabled.
+static void spi_poll()
+{
+  while((SPSR & (1<<SPIF))==0);
+  spi_transfer_complete();
+}
+
+
 uint8_t spi_fast_shift (uint8_t data)
-// Clocks only one byte to target device and returns the received one
+// Clocks only one byte to target device and returns the received one. Bypasses the queue, so only
+// use it while the queue is empty
 {
     SPDR = data;
     while((SPSR & (1<<SPIF))==0);
@@ -41,23 +111,67 @@ uint8_t spi_fast_shift (uint8_t data)
 }
 
 
+void spi_queue20bit(unsigned long datagram, volatile uint8_t *cs_port, uint8_t cs_bit, spi_callback_t callback)
+{
+  uint8_t sreg = SREG;
+  uint8_t next;
+  for (;;) {
+    cli();
+    next = spi_queue_next(spi_queue_head);
+    if (next != spi_queue_tail) { break; }
+    if (sreg & (1<<SREG_I)) {
+      SREG = sreg;  // Queue full. Wait for the interrupt to make room.
+    } else {
+      spi_poll();  // Interrupts are off, so make room here.
+    }
+  }
+  spi_queue[spi_queue_head].datagram = datagram & 0xFFFFFul;  // force to 20 bit
+  spi_queue[spi_queue_head].cs_port = cs_port;
+  spi_queue[spi_queue_head].cs_bit = cs_bit;
+  spi_queue[spi_queue_head].callback = callback;
+  if (spi_queue_head == spi_queue_tail) {
+    spi_queue_head = next;
+    spi_start_job();  // SPI idle. Start right away.
+  } else {
+    spi_queue_head = next;
+  }
+  SREG = sreg;
+}
+
+
+void spi_flush()
+{
+  uint8_t sreg = SREG;
+  if (sreg & (1<<SREG_I)) {
+    while (spi_queue_tail != spi_queue_head) {}
+  } else {
+    while (spi_queue_tail != spi_queue_head) { spi_poll(); }
+  }
+}
+
+
+static void spi_sync_callback(uint8_t cs_bit, unsigned long response)
+{
+  spi_sync_response = response;
+  spi_sync_done = 1;
+}
+
+
 // Send a 20 bit value via spi
 unsigned long spi_send20bit(unsigned long datagram, volatile uint8_t *cs_port, uint8_t cs_bit)
 {
-  unsigned long i_datagram;  // this is the returned value
-  
-  *cs_port &= ~(1<<cs_bit);  // chip select
-  
-  datagram &= 0xFFFFFul; // force to 20 bit
-  
-  i_datagram = spi_fast_shift((datagram >> 16) & 0xff);
-  i_datagram <<= 8;
-  i_datagram |= spi_fast_shift((datagram >>  8) & 0xff);
-  i_datagram <<= 8;
-  i_datagram |= spi_fast_shift((datagram) & 0xff);
-  i_datagram >>= 4;
-  
-   *cs_port |= (1<<cs_bit);   // deselect chip
-  
-  return i_datagram;
+  spi_sync_done = 0;
+  spi_queue20bit(datagram, cs_port, cs_bit, spi_sync_callback);
+  if (SREG & (1<<SREG_I)) {
+    while (!spi_sync_done) {}
+  } else {
+    while (!spi_sync_done) { spi_poll(); }
+  }
+  return spi_sync_response;
+}
+
+
+ISR(SPI_STC_vect)
+{
+  spi_transfer_complete();
 }
@@ -2,8 +2,27 @@
 #define _SPI_H_
 #include <avr/io.h>
 
+// Number of 20 bit datagrams the SPI queue holds. Queuing only waits when it's full. (2-255)
+#ifndef SPI_QUEUE_SIZE
+  #define SPI_QUEUE_SIZE 16
+#endif
+
+// Completion callback of a queued datagram. Called from the SPI interrupt with the chip select bit
+// of the transaction and the 20 bit response, so keep it short.
+typedef void (*spi_callback_t)(uint8_t cs_bit, unsigned long response);
+
 extern void spi_init();
 extern uint8_t spi_fast_shift (uint8_t data);
+
+// Queues a 20 bit datagram to the chip on cs_port/cs_bit and returns. The SPI interrupt shifts it
+// out and calls callback, if not NULL, with the response.
+extern void spi_queue20bit(unsigned long datagram, volatile uint8_t *cs_port, uint8_t cs_bit, spi_callback_t callback);
+
+// Sends a 20 bit datagram after the queued ones and waits for the response. Works with interrupts
+// disabled, e.g. at init. Main program only.
 extern unsigned long spi_send20bit(unsigned long datagram, volatile uint8_t *cs_port, uint8_t cs_bit);
 
+// Waits until all queued datagrams are sent.
+extern void spi_flush();
+
 #endif /* _SPI_H_ */
@@ -15,16 +15,13 @@
 static uint8_t enabled = 0U;
 static uint16_t spindle_current;
 static uint16_t spindle_I_max;
-static float spindle_I_max_amps;
 static uint8_t spindle_current_counter;
 
 void spindle_current_init( uint8_t enable )
 {
   enabled = enable;
   
-  spindle_I_max_amps = SPINDLE_I_THRESHOLD;
-  ps_settings_get_setting( 0, (uint8_t*)(&spindle_I_max_amps) );
-  spindle_current_set_threshold( spindle_I_max_amps );
+  spindle_current_load_threshold();
   
   if ( enabled )
   {
@@ -57,7 +54,6 @@ uint8_t spindle_current_proc( void )
     if ( spindle_current_counter == 0U )
     {
       unsigned long measurement = ADCL;
-      float previous_spindle_I_max_amps = spindle_I_max_amps;
       measurement += ((long)ADCH) << 8U;
       
       // apply filter algorithm and store result
@@ -65,13 +61,6 @@ uint8_t spindle_current_proc( void )
                          + (SPINDLE_I_MULTIPLIER - SPINDLE_I_AVG_CONST) * measurement )
                         / SPINDLE_I_MULTIPLIER;
       
-      ps_settings_get_setting( 0, (uint8_t*)(&spindle_I_max_amps) );
-      
-      if ( spindle_I_max_amps != spindle_I_max_amps )
-      {
-        spindle_current_set_threshold( spindle_I_max_amps );
-      }
-      
       // check against threshold
       if ( spindle_current > spindle_I_max )
       {
@@ -101,12 +90,29 @@ float spindle_current_get( void )
 
 void spindle_current_set_threshold( float threshold )
 {
+  uint16_t threshold_counts;
+  uint8_t sreg;
+  
   if ( threshold <= SPINDLE_I_SETTING_MAX )
   {
-    spindle_I_max = threshold / SPINDLE_CURRENT_AMPS_PER_COUNT;
+    threshold_counts = threshold / SPINDLE_CURRENT_AMPS_PER_COUNT;
   }
   else
   {
-    spindle_I_max = SPINDLE_I_SETTING_MAX / SPINDLE_CURRENT_AMPS_PER_COUNT;
+    threshold_counts = SPINDLE_I_SETTING_MAX / SPINDLE_CURRENT_AMPS_PER_COUNT;
   }
+  
+  // spindle_current_proc reads it from the timer5 interrupt
+  sreg = SREG;
+  cli();
+  spindle_I_max = threshold_counts;
+  SREG = sreg;
+}
+
+void spindle_current_load_threshold( void )
+{
+  float threshold = SPINDLE_I_THRESHOLD;
+  
+  ps_settings_get_value( PS_SETTING_SPINDLE_I_MAX, &threshold );
+  spindle_current_set_threshold( threshold );
 }
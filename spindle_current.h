@@ -38,4 +38,8 @@ extern float spindle_current_get( void );
 /// spindle_current_proc to not exceed SPINDLE_I_SETTING_MAX
 extern void spindle_current_set_threshold( float threshold );
 
+/// Sets the threshold current level from the product settings ($800)
+/// @note Main program only. Called at init and whenever the product settings change
+extern void spindle_current_load_threshold( void );
+
 #endif
@@ -64,6 +64,13 @@ typedef struct {
   #ifdef VARIABLE_SPINDLE
     uint8_t is_pwm_rate_adjusted; // Tracks motions that require constant laser power/rate
   #endif
+  #ifdef ENABLE_QUEUED_ACCESSORY_STATE
+    uint8_t accessory_update; // Queued accessory changes to apply as the block starts.
+    uint8_t coolant_state;    // Block coolant state. Applied only when flagged for update.
+  #endif
+  #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+    float wco[N_AXIS];        // Work coordinate offset of the block. Copied to sys_wco as it starts.
+  #endif
 } st_block_t;
 static st_block_t st_block_buffer[SEGMENT_BUFFER_SIZE-1];
 
@@ -369,6 +376,22 @@ ISR(TIMER1_COMPA_vect)
 
         // Initialize Bresenham line and distance counters
         st.counter_x = st.counter_y = st.counter_z = (st.exec_block->step_event_count >> 1);
+
+        #ifdef ENABLE_QUEUED_ACCESSORY_STATE
+          // Apply queued coolant change as the block starts. Queued spindle changes are applied
+          // through the segment spindle PWM below, which is always updated with a new block.
+          if (st.exec_block->accessory_update & PL_ACCESSORY_UPDATE_COOLANT) {
+            coolant_set_state(st.exec_block->coolant_state);
+          }
+          sys.accessory_applied |= st.exec_block->accessory_update; // Main program refreshes reports at cycle stop.
+        #endif
+        #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+          // Update the work coordinate offset reported for the executing motion.
+          if (memcmp(sys_wco, st.exec_block->wco, sizeof(sys_wco))) {
+            memcpy(sys_wco, st.exec_block->wco, sizeof(sys_wco));
+            sys.report_wco_counter = 0; // Set to report change immediately
+          }
+        #endif
       }
       st.dir_outbits = st.exec_block->direction_bits ^ dir_port_invert_mask;
 
@@ -665,6 +688,13 @@ void st_prep_buffer()
           for (idx=0; idx<N_AXIS; idx++) { st_prep_block->steps[idx] = pl_block->steps[idx] << MAX_AMASS_LEVEL; }
           st_prep_block->step_event_count = pl_block->step_event_count << MAX_AMASS_LEVEL;
         #endif
+        #ifdef ENABLE_QUEUED_ACCESSORY_STATE
+          st_prep_block->accessory_update = pl_block->accessory_update;
+          st_prep_block->coolant_state = pl_block->condition & (PL_COND_FLAG_COOLANT_FLOOD | PL_COND_FLAG_COOLANT_MIST);
+        #endif
+        #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+          memcpy(st_prep_block->wco, pl_block->wco, sizeof(pl_block->wco));
+        #endif
 
         // Initialize segment buffer data for generating the segments.
         prep.steps_remaining = (float)pl_block->step_event_count;
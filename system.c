@@ -150,6 +150,64 @@ void system_execute_startup(char *line)
 }
 
 
+#ifdef CARVIN
+  // Converts a product settings result into a status code.
+  static uint8_t system_ps_settings_status(uint8_t result)
+  {
+    switch (result) {
+      case PS_SETTINGS_OK: return(STATUS_OK);
+      case PS_SETTINGS_OUT_OF_RANGE: return(STATUS_SETTING_OUT_OF_RANGE);
+      case PS_SETTINGS_INVALID_IMAGE: return(STATUS_SETTING_IMAGE_INVALID);
+    }
+    return(STATUS_INVALID_STATEMENT);
+  }
+
+
+  // Executes the '$P' product settings registry commands. [IDLE/ALARM]
+  //   $P           Lists all parameters with their name, type, value, range, and units.
+  //   $P<id>       Lists parameter <id>, numbered from 800 like the '$<id>=' settings.
+  //   $P<id>=<val> Sets parameter <id>, if the value is within its range. Same as '$<id>=<val>'.
+  //   $PD          Dumps all values as one base64 bulk image.
+  //   $PL=<image>  Validates and stores all values of a bulk image from '$PD' at once, so a
+  //                machine is provisioned in one round trip.
+  static uint8_t system_execute_ps_settings_line(char *line)
+  {
+    uint8_t char_counter = 2;
+    uint8_t parameter;
+    uint8_t size;
+    float value;
+    uint8_t image[PS_SETTINGS_IMAGE_MAX_SIZE];
+    switch (line[char_counter]) {
+      case 0 :
+        for (parameter=0; parameter<PS_SETTINGS_NUM_PARAMETERS; parameter++) { report_ps_setting(parameter); }
+        return(STATUS_OK);
+      case 'D' :
+        if (line[3] != 0) { return(STATUS_INVALID_STATEMENT); }
+        report_ps_settings_image();
+        return(STATUS_OK);
+      case 'L' :
+        if (line[3] != '=') { return(STATUS_INVALID_STATEMENT); }
+        size = read_base64(&line[4], image, PS_SETTINGS_IMAGE_MAX_SIZE);
+        if (size == 0) { return(STATUS_SETTING_IMAGE_INVALID); }
+        return(system_ps_settings_status(ps_settings_load_image(image, size)));
+    }
+    if (!read_float(line, &char_counter, &value)) { return(STATUS_BAD_NUMBER_FORMAT); }
+    if ((value < PS_SETTINGS_FIRST_ID) || (value >= PS_SETTINGS_FIRST_ID+PS_SETTINGS_NUM_PARAMETERS)) {
+      return(STATUS_INVALID_STATEMENT);
+    }
+    parameter = trunc(value)-PS_SETTINGS_FIRST_ID;
+    if (line[char_counter] == 0) {
+      report_ps_setting(parameter);
+      return(STATUS_OK);
+    }
+    if (line[char_counter++] != '=') { return(STATUS_INVALID_STATEMENT); }
+    if (!read_float(line, &char_counter, &value)) { return(STATUS_BAD_NUMBER_FORMAT); }
+    if (line[char_counter] != 0) { return(STATUS_INVALID_STATEMENT); }
+    return(system_ps_settings_status(ps_settings_set_value(parameter, value)));
+  }
+#endif
+
+
 // Directs and executes one line of formatted input from protocol_process. While mostly
 // incoming streaming g-code blocks, this also executes Grbl internal commands, such as
 // settings, initiating the homing cycle, and toggling switch states. This differs from
@@ -165,6 +223,13 @@ uint8_t system_execute_line(char *line)
   float parameter, value;
   switch( line[char_counter] ) {
     case 0 : report_grbl_help(); break;
+    #ifdef ENABLE_RT_LATENCY_STATS
+      case 'T' : // Print or clear realtime command latency statistics [Any state]
+        if (line[2] == 0) { report_rt_latency(); }
+        else if ((line[2] == '=') && (line[3] == '0') && (line[4] == 0)) { system_rt_latency_clear(); }
+        else { return(STATUS_INVALID_STATEMENT); }
+        break;
+    #endif
     case 'J' : // Jogging
       // Execute only if in IDLE or JOG states.
       if (sys.state != STATE_IDLE && sys.state != STATE_JOG) { return(STATUS_IDLE_ERROR); }
@@ -172,6 +237,12 @@ uint8_t system_execute_line(char *line)
       return(gc_execute_line(line)); // NOTE: $J= is ignored inside g-code parser and used to detect jog motions.
       break;
     case '$': case 'G': case 'C': case 'X':
+    #ifdef ENABLE_BINARY_MOTION_STREAM
+      case 'B':
+    #endif
+    #ifdef ENABLE_SEQUENCED_STREAM
+      case 'A':
+    #endif
       if ( line[2] != 0 ) { return(STATUS_INVALID_STATEMENT); }
       switch( line[1] ) {
         case '$' : // Prints Grbl settings
@@ -204,6 +275,34 @@ uint8_t system_execute_line(char *line)
             // Don't run startup script. Prevents stored moves in startup from causing accidents.
           } // Otherwise, no effect.
           break;
+        #ifdef ENABLE_BINARY_MOTION_STREAM
+          case 'B' : // Toggle binary motion stream mode [Any state]
+            // NOTE: Allowed during a cycle, so a streaming interface may switch modes mid-job. The
+            // mode change takes effect with the next received line, in order with the stream.
+            if (sys.binary_motion) {
+              sys.binary_motion = false;
+              report_feedback_message(MESSAGE_DISABLED);
+            } else {
+              sys.binary_motion = true;
+              report_feedback_message(MESSAGE_ENABLED);
+            }
+            break;
+        #endif
+        #ifdef ENABLE_SEQUENCED_STREAM
+          case 'A' : // Toggle sequenced stream mode [Any state]
+            // NOTE: Enabling restarts the line sequence at zero. Any pending acknowledgment is
+            // sent before disabling.
+            if (sys.sequenced_stream) {
+              ss_flush_ack();
+              sys.sequenced_stream = false;
+              report_feedback_message(MESSAGE_DISABLED);
+            } else {
+              ss_reset();
+              sys.sequenced_stream = true;
+              report_feedback_message(MESSAGE_ENABLED);
+            }
+            break;
+        #endif
       }
       break;
     default :
@@ -250,6 +349,10 @@ uint8_t system_execute_line(char *line)
             return(STATUS_INVALID_STATEMENT);
           }
           break;
+        #ifdef CARVIN
+          case 'P' : // Product settings registry [IDLE/ALARM]
+            return(system_execute_ps_settings_line(line));
+        #endif
         case 'I' : // Print or store build info. [IDLE/ALARM]
           if ( line[++char_counter] == 0 ) {
             settings_read_build_info(line);
@@ -291,6 +394,19 @@ uint8_t system_execute_line(char *line)
           printPgmString(PSTR(" ]\r\n"));			
         break;
         #endif
+        #ifdef ENABLE_BAUD_RATE_COMMAND
+          case 'U' : // Switch serial baud rate [IDLE/ALARM]
+            if (line[++char_counter] != '=') { return(STATUS_INVALID_STATEMENT); }
+            char_counter++;
+            if (!read_float(line, &char_counter, &value)) { return(STATUS_BAD_NUMBER_FORMAT); }
+            if (line[char_counter] != 0) { return(STATUS_INVALID_STATEMENT); }
+            switch ((uint32_t)value) {
+              case 115200: case 250000: case 500000: case 1000000: break;
+              default: return(STATUS_INVALID_STATEMENT);
+            }
+            sys.baud_rate_request = value; // Switched by the main loop after the 'ok' is sent.
+            break;
+        #endif
         case 'R' : // Restore defaults [IDLE/ALARM]
           if ((line[2] != 'S') || (line[3] != 'T') || (line[4] != '=') || (line[6] != 0)) { return(STATUS_INVALID_STATEMENT); }
           switch (line[5]) {
@@ -350,7 +466,7 @@ uint8_t system_execute_line(char *line)
               }
               else
               {
-                return(ps_settings_store_setting( (uint8_t)(parameter - 800), (uint8_t*)(&value) ));
+                return(system_ps_settings_status(ps_settings_set_value((uint8_t)(parameter-PS_SETTINGS_FIRST_ID), value)));
               }
             #else
               if((line[char_counter] != 0) || (parameter > 255)) { return(STATUS_INVALID_STATEMENT); }
@@ -368,6 +484,12 @@ void system_flag_wco_change()
 {
   #ifdef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
     protocol_buffer_synchronize();
+  #else
+    // With no motion queued or executing, the new offset is in effect immediately. Otherwise, it
+    // takes effect when the next planned block starts or, if none follows, when motion completes.
+    if ((plan_get_current_block() == NULL) && !(sys.state & (STATE_CYCLE|STATE_HOLD|STATE_SAFETY_DOOR))) {
+      gc_get_wco(sys_wco);
+    }
   #endif
   sys.report_wco_counter = 0;
 }
@@ -394,6 +516,15 @@ float system_convert_axis_steps_to_mpos(int32_t *steps, uint8_t idx)
 }
 
 
+void system_get_wco(float *wco)
+{
+  uint8_t sreg = SREG;
+  cli(); // The stepper ISR may replace sys_wco between floats.
+  memcpy(wco, sys_wco, sizeof(sys_wco));
+  SREG = sreg;
+}
+
+
 void system_convert_array_steps_to_mpos(float *position, int32_t *steps)
 {
   uint8_t idx;
@@ -495,3 +626,71 @@ void system_clear_exec_accessory_overrides() {
   sys_rt_exec_accessory_override = 0;
   SREG = sreg;
 }
+
+
+#ifdef ENABLE_RT_LATENCY_STATS
+  volatile rt_latency_t sys_rt_latency;
+
+  void system_rt_latency_start(uint8_t data)
+  {
+    uint8_t command;
+    switch (data) {
+      case CMD_STATUS_REPORT: command = RT_LATENCY_STATUS_REPORT; break;
+      case CMD_FEED_HOLD: case CMD_SAFETY_DOOR:
+      #ifdef CARVIN
+        case CMD_LEGACY_SAFETY_DOOR:
+      #endif
+        command = RT_LATENCY_FEED_HOLD; break;
+      case CMD_CYCLE_START: command = RT_LATENCY_CYCLE_START; break;
+      case CMD_JOG_CANCEL: command = RT_LATENCY_JOG_CANCEL; break;
+      default:
+        if ((data < CMD_FEED_OVR_RESET) || (data > CMD_COOLANT_MIST_OVR_TOGGLE)) { return; }
+        command = RT_LATENCY_OVERRIDE;
+    }
+    // Repeats before the command is serviced are merged. Measure from the first one.
+    if (bit_isfalse(sys_rt_latency.pending,bit(command))) {
+      sys_rt_latency.start[command] = carvin_get_timer_count();
+      sys_rt_latency.pending |= bit(command);
+    }
+  }
+
+
+  void system_rt_latency_end()
+  {
+    if (!sys_rt_latency.pending) { return; } // Fast path. Read in a single instruction.
+    uint8_t command, bin;
+    uint32_t latency, limit;
+    for (command=0; command<RT_LATENCY_N_COMMANDS; command++) {
+      uint8_t sreg = SREG;
+      cli();
+      if (bit_isfalse(sys_rt_latency.pending,bit(command))) {
+        SREG = sreg;
+        continue;
+      }
+      // NOTE: Read the time with the RX ISR held off, so a command stamped by it can't be later than
+      // the end time and read as a wrapped, two minute latency.
+      latency = carvin_get_elapsed_us(sys_rt_latency.start[command], carvin_get_timer_count());
+      sys_rt_latency.pending &= ~bit(command);
+      SREG = sreg;
+
+      // Statistics are only touched by the main program from here on.
+      if (sys_rt_latency.count[command] < 0xFFFF) { sys_rt_latency.count[command]++; }
+      if (latency > sys_rt_latency.max[command]) { sys_rt_latency.max[command] = latency; }
+      limit = 128;
+      for (bin=0; bin<(RT_LATENCY_N_BINS-1); bin++) {
+        if (latency < limit) { break; }
+        limit <<= 1;
+      }
+      if (sys_rt_latency.histogram[bin] < 0xFFFF) { sys_rt_latency.histogram[bin]++; }
+    }
+  }
+
+
+  void system_rt_latency_clear()
+  {
+    uint8_t sreg = SREG;
+    cli();
+    memset((void*)&sys_rt_latency, 0, sizeof(rt_latency_t));
+    SREG = sreg;
+  }
+#endif
@@ -48,6 +48,7 @@
 #define EXEC_ALARM_HOMING_FAIL_DOOR     7
 #define EXEC_ALARM_HOMING_FAIL_PULLOFF  8
 #define EXEC_ALARM_HOMING_FAIL_APPROACH 9
+#define EXEC_ALARM_MOTOR_STALL          10 // Carvin. Motor load reached the stall margin.
 
 // Override bit maps. Realtime bitflags to control feed, rapid, spindle, and coolant overrides.
 // Spindle/coolant and feed/rapids are separated into two controlling flag variables.
@@ -138,6 +139,25 @@ typedef struct {
   uint8_t spindle_stop_ovr;    // Tracks spindle stop override states
   uint8_t report_ovr_counter;  // Tracks when to add override data to status reports.
   uint8_t report_wco_counter;  // Tracks when to add work coordinate offset data to status reports.
+  #ifdef ENABLE_COMPACT_STATUS_REPORT
+    uint8_t report_compact_counter; // Tracks when to send all fields in compact status reports.
+  #endif
+  #ifdef ENABLE_BINARY_MOTION_STREAM
+    uint8_t binary_motion;     // Tracks binary motion stream mode. Cleared upon reset.
+  #endif
+  #ifdef ENABLE_SEQUENCED_STREAM
+    uint8_t sequenced_stream;  // Tracks sequenced stream mode. Cleared upon reset.
+  #endif
+  #ifdef ENABLE_PROGRAM_MODE
+    uint8_t program_mode;      // Tracks '%' delimited program mode. Cleared upon reset.
+  #endif
+  #ifdef ENABLE_BAUD_RATE_COMMAND
+    uint32_t baud_rate_request; // Baud rate to switch to after the '$U' command is acknowledged.
+  #endif
+  #ifdef ENABLE_QUEUED_ACCESSORY_STATE
+    uint8_t accessory_update;  // Accessory changes queued for the next planned block. See PL_ACCESSORY flags.
+    uint8_t accessory_applied; // Queued accessory changes the stepper applied since the last cycle stop.
+  #endif
   #ifdef VARIABLE_SPINDLE
     float spindle_speed;
   #endif
@@ -147,6 +167,9 @@ extern system_t sys;
 // NOTE: These position variables may need to be declared as volatiles, if problems arise.
 int32_t sys_position[N_AXIS];      // Real-time machine (aka home) position vector in steps.
 int32_t sys_probe_position[N_AXIS]; // Last probe position in machine coordinates and steps.
+#ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+  float sys_wco[N_AXIS];            // Work coordinate offset of the executing motion. Used by status reports.
+#endif
 
 volatile uint8_t sys_probe_state;   // Probing state value.  Used to coordinate the probing cycle with stepper ISR.
 volatile uint8_t sys_rt_exec_state;   // Global realtime executor bitflag variable for state management. See EXEC bitmasks.
@@ -159,6 +182,27 @@ volatile uint8_t sys_rt_exec_accessory_override; // Global realtime executor bit
   volatile uint8_t sys_rt_exec_debug;
 #endif
 
+#ifdef ENABLE_RT_LATENCY_STATS
+  // Realtime command types tracked by the latency statistics.
+  #define RT_LATENCY_STATUS_REPORT 0
+  #define RT_LATENCY_FEED_HOLD     1 // Feed hold and safety door
+  #define RT_LATENCY_CYCLE_START   2
+  #define RT_LATENCY_JOG_CANCEL    3
+  #define RT_LATENCY_OVERRIDE      4 // Feed, rapid, spindle, and coolant overrides
+  #define RT_LATENCY_N_COMMANDS    5
+  // Latency histogram bins. Bin n counts latencies below 2^(n+7) usec. The last bin counts the rest.
+  #define RT_LATENCY_N_BINS        12
+
+  typedef struct {
+    uint32_t start[RT_LATENCY_N_COMMANDS]; // Receipt time of the oldest unserviced command.
+    uint8_t pending;                       // Bitflags of command types awaiting service.
+    uint16_t count[RT_LATENCY_N_COMMANDS]; // Serviced commands. Saturates.
+    uint32_t max[RT_LATENCY_N_COMMANDS];   // Maximum latency (usec).
+    uint16_t histogram[RT_LATENCY_N_BINS]; // Saturates.
+  } rt_latency_t;
+  extern volatile rt_latency_t sys_rt_latency; // NOT cleared by a reset.
+#endif
+
 // Initialize the serial protocol
 void system_init();
 
@@ -177,6 +221,9 @@ void system_execute_startup(char *line);
 
 void system_flag_wco_change();
 
+// Copies the work coordinate offset of the executing motion, which the stepper ISR updates.
+void system_get_wco(float *wco);
+
 // Returns machine position of axis 'idx'. Must be sent a 'step' array.
 float system_convert_axis_steps_to_mpos(int32_t *steps, uint8_t idx);
 
@@ -207,5 +254,13 @@ void system_set_exec_accessory_override_flag(uint8_t mask);
 void system_clear_exec_motion_overrides();
 void system_clear_exec_accessory_overrides();
 
+#ifdef ENABLE_RT_LATENCY_STATS
+  // Timestamps a realtime command character upon receipt. Called by the serial RX ISR.
+  void system_rt_latency_start(uint8_t data);
+  // Records the latency of all pending realtime commands. Called when they are serviced.
+  void system_rt_latency_end();
+  void system_rt_latency_clear();
+#endif
+
 
 #endif
@@ -0,0 +1,32 @@
+/*
+  avr/interrupt.h - host stand-in for the AVR interrupt macros, for the tests in this directory
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// There are no interrupts on the host. An ISR is an ordinary function a test may call.
+
+#ifndef avr_interrupt_h
+#define avr_interrupt_h
+
+#include "io.h"
+
+#define ISR(vector) static void __attribute__((unused)) vector(void)
+#define cli() (SREG &= ~(1<<SREG_I))
+#define sei() (SREG |= (1<<SREG_I))
+
+#endif
@@ -0,0 +1,32 @@
+/*
+  avr/io.h - host stand-in for the AVR register definitions, for the tests in this directory
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Only the status register is common to all tests. Each test emulates the peripheral registers
+// of the code it includes, before including it. Interrupts start disabled, like at reset.
+
+#ifndef avr_io_h
+#define avr_io_h
+
+#include <stdint.h>
+
+static uint8_t __attribute__((unused)) SREG = 0;
+#define SREG_I 7
+
+#endif
@@ -0,0 +1,37 @@
+/*
+  avr/pgmspace.h - host stand-in for the AVR program memory access, for the tests in this directory
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The host has one address space, so program memory is ordinary memory.
+
+#ifndef avr_pgmspace_h
+#define avr_pgmspace_h
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_byte_near(address) (*(const uint8_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+#define memcpy_P memcpy
+#define memcmp_P memcmp
+
+#endif
@@ -0,0 +1,29 @@
+/*
+  avr/wdt.h - host stand-in for the AVR watchdog macros, for the tests in this directory
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef avr_wdt_h
+#define avr_wdt_h
+
+#define WDTO_15MS 0
+#define wdt_enable(timeout)
+#define wdt_disable()
+#define wdt_reset()
+
+#endif
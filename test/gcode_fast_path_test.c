@@ -0,0 +1,311 @@
+/*
+  gcode_fast_path_test.c - host test of the g-code modal fast path against the full parser
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  Runs on the host, not the controller. From the repository root:
+
+    cc -O2 -Itest -o gcode_fast_path_test test/gcode_fast_path_test.c -lm && ./gcode_fast_path_test
+
+  gcode.c is compiled twice: once without ENABLE_GCODE_MODAL_FAST_PATH, with its symbols renamed
+  to *_full, and once as configured. Every line is executed by both parsers, each on its own state.
+  The status, every planned motion (target and plan data, compared bit for bit) and the resulting
+  parser state must match. The lines the fast path is expected to take must take it, which is seen
+  by gc_block being left untouched. Lines cover units, distance modes, work coordinate systems,
+  G92 and tool length offsets, modal changes between motions, and the ineligible and erroneous
+  blocks that must fall through to the full parser. Reports the execution time per line of both
+  parsers for a typical dense toolpath block as a rough host benchmark.
+*/
+
+#ifndef F_CPU
+  #define F_CPU 16000000UL
+#endif
+#include "../grbl.h"
+#include <stdio.h>
+#include <time.h>
+
+#ifndef ENABLE_GCODE_MODAL_FAST_PATH
+  #error "Nothing to test. ENABLE_GCODE_MODAL_FAST_PATH is disabled in config.h."
+#endif
+
+// Module state and calls of the rest of Grbl used by the parser. Planned motions are logged.
+system_t sys;
+settings_t settings;
+int32_t sys_position[N_AXIS];
+float sys_wco[N_AXIS];
+volatile uint8_t sys_rt_exec_state;
+static float coord_data[SETTING_INDEX_NCOORD+1][N_AXIS];
+
+#define MAX_MOTIONS 4
+typedef struct {
+  uint8_t n_motions;
+  float target[MAX_MOTIONS][N_AXIS];
+  plan_line_data_t pl_data[MAX_MOTIONS];
+} motion_log_t;
+static motion_log_t motion_log;
+
+void mc_line(float *target, plan_line_data_t *pl_data)
+{
+  if (motion_log.n_motions < MAX_MOTIONS) {
+    memcpy(motion_log.target[motion_log.n_motions], target, sizeof(float)*N_AXIS);
+    memcpy(&motion_log.pl_data[motion_log.n_motions], pl_data, sizeof(plan_line_data_t));
+  }
+  motion_log.n_motions++;
+}
+void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *offset, float radius,
+  uint8_t axis_0, uint8_t axis_1, uint8_t axis_linear, uint8_t is_clockwise_arc) { mc_line(target, pl_data); }
+void mc_dwell(float seconds) {}
+uint8_t mc_probe_cycle(float *target, plan_line_data_t *pl_data, uint8_t parser_flags) { return(GC_PROBE_FOUND); }
+uint8_t jog_execute(plan_line_data_t *pl_data, parser_block_t *gc_block) { mc_line(gc_block->values.xyz, pl_data); return(STATUS_OK); }
+void coolant_set_state(uint8_t mode) {}
+void coolant_sync(uint8_t mode) {}
+void spindle_set_state(uint8_t state, float rpm) {}
+void spindle_sync(uint8_t state, float rpm) {}
+plan_block_t *plan_get_current_block() { return(NULL); }
+void protocol_buffer_synchronize() {}
+void protocol_execute_realtime() {}
+void protocol_exec_rt_system() {}
+void report_feedback_message(uint8_t message_code) {}
+void report_status_message(uint8_t status_code) {}
+void settings_write_coord_data(uint8_t coord_select, float *data) { memcpy(coord_data[coord_select], data, sizeof(coord_data[0])); }
+uint8_t settings_read_coord_data(uint8_t coord_select, float *data) { memcpy(data, coord_data[coord_select], sizeof(coord_data[0])); return(true); }
+void system_convert_array_steps_to_mpos(float *position, int32_t *steps) { memset(position, 0, sizeof(float)*N_AXIS); }
+void system_flag_wco_change() {}
+void system_set_exec_state_flag(uint8_t mask) {}
+
+#include "../nuts_bolts.c"
+
+// The full parser only.
+#undef ENABLE_GCODE_MODAL_FAST_PATH
+#define gc_state gc_state_full
+#define gc_block gc_block_full
+#define gc_init gc_init_full
+#define gc_sync_position gc_sync_position_full
+#define gc_get_wco gc_get_wco_full
+#define gc_execute_line gc_execute_line_full
+void gc_get_wco_full(float *wco); // gcode.h declared the configured parser's functions only.
+#ifdef ENABLE_QUEUED_ACCESSORY_STATE
+  #define gc_queue_accessory_update gc_queue_accessory_update_full
+#endif
+#include "../gcode.c"
+#undef gc_state
+#undef gc_block
+#undef gc_init
+#undef gc_sync_position
+#undef gc_get_wco
+#undef gc_execute_line
+#undef gc_queue_accessory_update
+
+// The parser as configured, with the fast path.
+#define ENABLE_GCODE_MODAL_FAST_PATH
+#include "../gcode.c"
+
+
+typedef struct {
+  const char *line;
+  bool fast; // Expected to take the fast path.
+} test_line_t;
+
+static const test_line_t test_lines[] = {
+  { "G1X1", false },          // Feed rate undefined. Error.
+  { "G21G90G54G17G94", false },
+  { "G0X0Y0Z0", false },
+  { "X1.5Y-2.25", true },     // Modal G0.
+  { "Z-0.123456", true },
+  { "G1F1000", false },
+  { "X10Y10", true },         // Modal G1.
+  { "Y12.3456Z-1.5X9.87", true },
+  { "X-0.0001", true },
+  { "X1X2", false },          // Repeated word. Error.
+  { "X", false },             // Missing value. Error.
+  { "XY1", false },
+  { "X1A2", false },          // Unsupported axis. Error.
+  { "N10X2", false },         // Line number.
+  { "X3", true },             // Line number reset.
+  { "F500X4", false },
+  { "X5", true },
+  { "G91", false },
+  { "X0.1", true },           // Incremental.
+  { "Y-0.3Z0.05", true },
+  { "X0.1Y0.1Z0.1", true },
+  { "G90", false },
+  { "G20", false },
+  { "X1Y1", true },           // Inches.
+  { "Z-0.0625", true },
+  { "G91", false },
+  { "X0.01", true },          // Incremental inches.
+  { "G90G21", false },
+  { "G10L2P1X1Y2Z3", false }, // G54 offset.
+  { "X5Y5", true },
+  { "G10L20P2X0Y0Z0", false },
+  { "G55", false },
+  { "X1Y-1Z2", true },
+  { "G54", false },
+  { "G92X0Y0Z0", false },     // G92 offset.
+  { "X1Y1Z1", true },
+  { "G92.1", false },
+  { "X2", true },
+  { "G43.1Z0.5", false },     // Tool length offset.
+  { "Z1", true },
+  { "X3Z-1", true },
+  { "G49", false },
+  { "Z2", true },
+  { "M3S10000", false },      // Spindle and coolant state in the plan data.
+  { "X4", true },
+  { "M8", false },
+  { "X5Y6", true },
+  { "M5M9", false },
+  { "T2X1", false },          // Tool number.
+  { "X2", true },             // Tool number reset.
+  { "G0", false },
+  { "X0Y0Z5", true },
+  { "G1X1F200", false },
+  { "G93", false },           // Inverse time.
+  { "X2F10", false },
+  { "X3", false },            // Inverse time needs F. Error.
+  { "G94", false },
+  { "X4", false },            // Feed rate undefined after G93. Error.
+  { "F300", false },
+  { "X5", true },
+  { "G2X6Y1I0.5J0.5", false },// Arc motion mode.
+  { "X7Y2", false },          // Arc without offsets. Error.
+  { "G80", false },           // Motion mode cancel.
+  { "X8", false },            // Axis words without motion. Error.
+  { "G1X9", false },
+  { "X10", true },
+  { "$J=G91X1F100", false },  // Jog.
+  { "X11", true },
+};
+
+#define N_TEST_LINES (sizeof(test_lines)/sizeof(test_lines[0]))
+
+
+static bool motion_logs_match(const motion_log_t *a, const motion_log_t *b)
+{
+  uint8_t idx;
+  if (a->n_motions != b->n_motions) { return(false); }
+  for (idx=0; (idx<a->n_motions) && (idx<MAX_MOTIONS); idx++) {
+    if (memcmp(a->target[idx], b->target[idx], sizeof(a->target[idx]))) { return(false); }
+    if (memcmp(&a->pl_data[idx], &b->pl_data[idx], sizeof(a->pl_data[idx]))) { return(false); }
+  }
+  return(true);
+}
+
+
+// Executes a line with a parser, as protocol_main_loop() does. Returns the status.
+static uint8_t execute(uint8_t (*execute_line)(char *line), const char *test, motion_log_t *log)
+{
+  char line[LINE_BUFFER_SIZE];
+  uint8_t status;
+  strcpy(line, test);
+  memset(&motion_log, 0, sizeof(motion_log));
+  status = execute_line(line); // Jog lines are passed with the '$J=' prefix, as by system.c.
+  memcpy(log, &motion_log, sizeof(motion_log));
+  return(status);
+}
+
+
+// Executes a line on both parsers. Returns the number of failures.
+static unsigned long compare_line(const test_line_t *test, unsigned long *n_fast)
+{
+  static parser_block_t untouched;
+  motion_log_t full_log, fast_log;
+  uint8_t full_status, fast_status;
+  unsigned long n_failed = 0;
+  char line[LINE_BUFFER_SIZE];
+
+  full_status = execute(gc_execute_line_full, test->line, &full_log);
+  memset(&untouched, 0xa5, sizeof(untouched));
+  memcpy(&gc_block, &untouched, sizeof(gc_block));
+  fast_status = execute(gc_execute_line, test->line, &fast_log);
+  bool fast = (memcmp(&gc_block, &untouched, sizeof(gc_block)) == 0);
+  if (fast) { (*n_fast)++; }
+
+  strcpy(line, test->line);
+  if (fast_status != full_status) {
+    printf("FAIL %s: status %u, full parser %u\n", line, fast_status, full_status);
+    n_failed++;
+  }
+  if (!motion_logs_match(&fast_log, &full_log)) {
+    printf("FAIL %s: planned motion differs from the full parser\n", line);
+    n_failed++;
+  }
+  if (memcmp(&gc_state, &gc_state_full, sizeof(gc_state))) {
+    printf("FAIL %s: parser state differs from the full parser\n", line);
+    n_failed++;
+  }
+  if (fast != test->fast) {
+    printf("FAIL %s: %s the fast path\n", line, fast ? "took" : "didn't take");
+    n_failed++;
+  }
+  return(n_failed);
+}
+
+
+static void setup()
+{
+  memset(&sys, 0, sizeof(sys));
+  memset(&settings, 0, sizeof(settings));
+  memset(coord_data, 0, sizeof(coord_data));
+  gc_init_full();
+  gc_init();
+}
+
+
+int main()
+{
+  unsigned long n_failed = 0;
+  unsigned long n_fast = 0;
+  uint8_t idx;
+
+  setup();
+  for (idx=0; idx<N_TEST_LINES; idx++) { n_failed += compare_line(&test_lines[idx], &n_fast); }
+
+  // Laser mode always takes the full parser.
+  setup();
+  settings.flags |= BITFLAG_LASER_MODE;
+  const test_line_t laser_lines[] = { { "G1F1000", false }, { "M4S100", false }, { "X1Y1", false }, { "X2", false } };
+  for (idx=0; idx<4; idx++) { n_failed += compare_line(&laser_lines[idx], &n_fast); }
+
+  printf("%u lines, %lu on the fast path, %lu failed\n", (unsigned)(N_TEST_LINES+4), n_fast, n_failed);
+
+  // Rough host benchmark of a dense 3D toolpath block.
+  setup();
+  char line[LINE_BUFFER_SIZE];
+  clock_t start;
+  unsigned long count;
+  strcpy(line, "G1F1000");
+  gc_execute_line_full(line);
+  strcpy(line, "G1F1000");
+  gc_execute_line(line);
+  start = clock();
+  for (count=0; count<2000000; count++) {
+    strcpy(line, "X12.345Y-6.789Z-0.125");
+    gc_execute_line_full(line);
+  }
+  printf("full parser: %.1f ns/line\n", 1e9*(clock()-start)/CLOCKS_PER_SEC/2000000.0);
+  start = clock();
+  for (count=0; count<2000000; count++) {
+    strcpy(line, "X12.345Y-6.789Z-0.125");
+    gc_execute_line(line);
+  }
+  printf("fast path:   %.1f ns/line\n", 1e9*(clock()-start)/CLOCKS_PER_SEC/2000000.0);
+
+  return(n_failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
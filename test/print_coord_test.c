@@ -0,0 +1,254 @@
+/*
+  print_coord_test.c - host test of the integer position output against the float output it replaced
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  Runs on the host, not the controller. From the repository root:
+
+    cc -O2 -Itest -o print_coord_test test/print_coord_test.c -lm && ./print_coord_test
+
+  Positions are printed from steps by print_convert_steps_to_coord_units() and printCoord_Units(),
+  and by the float path the status report used before: steps/steps_per_mm, then the original
+  printFloat_CoordValue(), reproduced below. Both run in mm and inch mode at the configured
+  N_DECIMAL_COORDVALUE places, for several step rates, over every position within +/-200000 steps,
+  random positions, and the largest positions whose coordinate units still fit an int32, where
+  the fixed-point math is closest to wrapping. The printed values must be equal within the float
+  rounding error of the old path, and must be formatted identically. The old path printed "-0.000"
+  for positions that round to zero from below. That's the one difference accepted.
+  Also checks printFloat() and print_uint32_base10(), which now share the digit generator, against
+  the original printFloat() and printf(), up to the largest uint32.
+*/
+
+#ifndef F_CPU
+  #define F_CPU 16000000UL
+#endif
+#include "../grbl.h"
+#include <stdio.h>
+
+settings_t settings;
+
+static char output[32];
+static uint8_t output_length;
+
+void serial_write(uint8_t data)
+{
+  if (output_length < sizeof(output)-1) { output[output_length++] = data; }
+  output[output_length] = 0;
+}
+
+#include "../print.c"
+
+
+// printFloat() and printFloat_CoordValue() before the integer position output.
+static void reference_printFloat(float n, uint8_t decimal_places)
+{
+  if (n < 0) {
+    serial_write('-');
+    n = -n;
+  }
+
+  uint8_t decimals = decimal_places;
+  while (decimals >= 2) { // Quickly convert values expected to be E0 to E-4.
+    n *= 100;
+    decimals -= 2;
+  }
+  if (decimals) { n *= 10; }
+  n += 0.5; // Add rounding factor. Ensures carryover through entire value.
+
+  // Generate digits backwards and store in string.
+  unsigned char buf[13];
+  uint8_t i = 0;
+  uint32_t a = (long)n;
+  while(a > 0) {
+    buf[i++] = (a % 10) + '0'; // Get digit
+    a /= 10;
+  }
+  while (i < decimal_places) {
+     buf[i++] = '0'; // Fill in zeros to decimal point for (n < 1)
+  }
+  if (i == decimal_places) { // Fill in leading zero, if needed.
+    buf[i++] = '0';
+  }
+
+  // Print the generated string.
+  for (; i > 0; i--) {
+    if (i == decimal_places) { serial_write('.'); } // Insert decimal point in right place.
+    serial_write(buf[i-1]);
+  }
+}
+
+static void reference_printFloat_CoordValue(float n) {
+  if (bit_istrue(settings.flags,BITFLAG_REPORT_INCHES)) {
+    reference_printFloat(n*INCH_PER_MM,N_DECIMAL_COORDVALUE_INCH);
+  } else {
+    reference_printFloat(n,N_DECIMAL_COORDVALUE_MM);
+  }
+}
+
+
+static void print_new(int32_t steps, uint8_t idx, char *string)
+{
+  output_length = 0;
+  printCoord_Units(print_convert_steps_to_coord_units(steps, idx));
+  strcpy(string, output);
+}
+
+
+static void print_old(int32_t steps, uint8_t idx, char *string)
+{
+  output_length = 0;
+  reference_printFloat_CoordValue((float)steps/settings.steps_per_mm[idx]);
+  strcpy(string, output);
+}
+
+
+// Printed value in coordinate units. The decimal point must be at the configured place.
+static bool parse_units(const char *string, uint8_t decimal_places, int64_t *units)
+{
+  const char *dot = strchr(string, '.');
+  if (!dot || (strlen(dot+1) != decimal_places) || (dot == string) || (dot[-1] == '-')) { return(false); }
+  int64_t value = 0;
+  const char *c;
+  for (c=string; *c; c++) {
+    if ((*c == '-') && (c == string)) { continue; }
+    if (*c == '.') { continue; }
+    if ((*c < '0') || (*c > '9')) { return(false); }
+    value = 10*value + (*c-'0');
+  }
+  *units = (string[0] == '-') ? -value : value;
+  return(true);
+}
+
+
+static unsigned long n_tested = 0, n_failed = 0;
+static double max_difference = 0;
+
+static void check_position(int32_t steps, uint8_t idx, bool inches)
+{
+  char new_string[32], old_string[32];
+  int64_t new_units, old_units;
+  uint8_t decimal_places = inches ? N_DECIMAL_COORDVALUE_INCH : N_DECIMAL_COORDVALUE_MM;
+  double units_per_mm = inches ? 10000.0*INCH_PER_MM : 1000.0; // Both paths use the rounded constant.
+  double exact = (double)steps/settings.steps_per_mm[idx]*units_per_mm;
+
+  print_new(steps, idx, new_string);
+  print_old(steps, idx, old_string);
+  n_tested++;
+
+  // The old float path loses up to a few float ulps of the value. The fixed-point scale is exact
+  // to float precision, so the new value is within rounding of the exact value, plus that.
+  double float_error = 4*fabs(exact)/16777216.0;
+  if (!parse_units(new_string, decimal_places, &new_units) ||
+      (fabs(new_units - exact) > 0.5 + float_error)) {
+    if (n_failed++ < 10) { printf("FAIL %ld steps, axis %u: %s, exact %.4f units\n", (long)steps, idx, new_string, exact); }
+    return;
+  }
+  if (!parse_units(old_string, decimal_places, &old_units) ||
+      (fabs((double)(new_units - old_units)) > 1 + 2*float_error)) {
+    if (n_failed++ < 10) { printf("FAIL %ld steps, axis %u: %s, old %s\n", (long)steps, idx, new_string, old_string); }
+    return;
+  }
+  if (new_units == old_units) {
+    if (strcmp(new_string, old_string) && !((new_units == 0) && (old_string[0] == '-') && !strcmp(new_string, old_string+1))) {
+      if (n_failed++ < 10) { printf("FAIL %ld steps, axis %u: format %s, old %s\n", (long)steps, idx, new_string, old_string); }
+    }
+  }
+  if ((fabs(exact) < 16777216.0) && (fabs(new_units - exact) > max_difference)) {
+    max_difference = fabs(new_units - exact);
+  }
+}
+
+
+static void check_digits()
+{
+  char expected[32];
+  uint32_t n;
+  uint8_t decimal_places;
+  unsigned long idx;
+  const uint32_t edges[] = { 0, 1, 9, 10, 99, 100, 999999999UL, 1000000000UL, 2147483647UL,
+                             2147483648UL, 4294967294UL, 4294967295UL };
+
+  for (idx=0; idx<sizeof(edges)/sizeof(edges[0]); idx++) {
+    n = edges[idx];
+    output_length = 0;
+    print_uint32_base10(n);
+    sprintf(expected, "%lu", (unsigned long)n);
+    n_tested++;
+    if (strcmp(output, expected)) {
+      if (n_failed++ < 10) { printf("FAIL print_uint32_base10(%lu): %s\n", (unsigned long)n, output); }
+    }
+  }
+
+  // printFloat() at 0-4 decimal places, over values of any magnitude the old code printed.
+  srand(1);
+  for (idx=0; idx<2000000; idx++) {
+    float value = (rand()/(float)RAND_MAX - 0.5f) * powf(10.0f, (rand() % 10) - 3);
+    decimal_places = rand() % 5;
+    if (fabsf(value)*powf(10.0f, decimal_places) >= 2147483647.0f) { continue; }
+    output_length = 0;
+    reference_printFloat(value, decimal_places);
+    strcpy(expected, output);
+    output_length = 0;
+    printFloat(value, decimal_places);
+    n_tested++;
+    if (strcmp(output, expected)) {
+      if (n_failed++ < 10) { printf("FAIL printFloat(%.9g, %u): %s, old %s\n", value, decimal_places, output, expected); }
+    }
+  }
+}
+
+
+int main()
+{
+  const float steps_per_mm[][N_AXIS] = {
+    { DEFAULT_X_STEPS_PER_MM, DEFAULT_Y_STEPS_PER_MM, DEFAULT_Z_STEPS_PER_MM },
+    { 5120.0, 250.0, 0.5 },
+    { 80.0, 3000.0, 1000.0 } };
+  uint8_t n_rates = sizeof(steps_per_mm)/sizeof(steps_per_mm[0]);
+  uint8_t rate, idx, inches;
+  int32_t steps, limit;
+
+  check_digits();
+
+  srand(1);
+  for (rate=0; rate<n_rates; rate++) {
+    memcpy(settings.steps_per_mm, steps_per_mm[rate], sizeof(settings.steps_per_mm));
+    for (inches=0; inches<2; inches++) {
+      settings.flags = inches ? BITFLAG_REPORT_INCHES : 0;
+      print_coord_scale_init();
+      for (idx=0; idx<N_AXIS; idx++) {
+        for (steps=-200000; steps<=200000; steps++) { check_position(steps, idx, inches); }
+        // Largest position whose coordinate units fit an int32, and the float path still prints.
+        double units_per_step = (inches ? 10000.0*INCH_PER_MM : 1000.0)/settings.steps_per_mm[idx];
+        limit = (units_per_step > 1.0) ? (int32_t)(2147483000.0/units_per_step) : 2147483000;
+        for (steps=limit-1000; steps<=limit; steps++) {
+          check_position(steps, idx, inches);
+          check_position(-steps, idx, inches);
+        }
+        for (steps=0; steps<200000; steps++) {
+          int32_t position = (int32_t)(((double)rand()/RAND_MAX*2.0 - 1.0)*limit);
+          check_position(position, idx, inches);
+        }
+      }
+    }
+  }
+
+  printf("%lu values, %lu failed, largest difference from exact below 2^24 units %.3f units\n", n_tested, n_failed, max_difference);
+  return(n_failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
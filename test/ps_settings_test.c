@@ -0,0 +1,374 @@
+/*
+  ps_settings_test.c - host test of the product settings boot-time load against an emulated EEPROM
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  Runs on the host, not the controller. From the repository root:
+
+    cc -O2 -Itest -o ps_settings_test test/ps_settings_test.c -lm && ./ps_settings_test
+
+  eeprom.c, journal.c and ps_settings.c are compiled as is, on top of an emulation of the EEPROM
+  control registers. Each case lays out an EEPROM image, then boots as main() does: journal_init()
+  (from settings_init()), then ps_settings_init(). Covered are a blank EEPROM, a current revision 2
+  image, a revision 1 image with the Grbl checksum, a smaller image from older firmware, corrupted
+  images, and journaled values on top of the image. A boot from a valid image must not write the
+  EEPROM. Reports the number of EEPROM bytes ps_settings_init() reads on such a boot, which is
+  its boot-time cost.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+// Compile the EEPROM modules without the rest of grbl.h.
+#define grbl_h
+#include "../config.h"
+#include "../eeprom.h"
+#include "../journal.h"
+
+// ATmega2560 EEPROM. Control register bits and the programming modes eeprom.c selects.
+#define EEPROM_SIZE 4096
+#define EERE  0
+#define EEPE  1
+#define EEMPE 2
+#define EERIE 3
+#define EEPROM_MODE(control) (((control) >> 4) & 3) // EEPM1:0. Erase+Write, Erase, Write.
+
+static uint8_t eeprom[EEPROM_SIZE];
+static unsigned int eeprom_address;
+static uint8_t eeprom_data, eeprom_control;
+static unsigned long eeprom_n_read, eeprom_n_written;
+
+// Completes the operation the previous control register write started. The hardware reads at
+// once and programs within 3.3 msec. Either is done by the next register access.
+static void eeprom_complete()
+{
+  if (eeprom_control & (1<<EERE)) {
+    eeprom_data = eeprom[eeprom_address];
+    eeprom_control &= ~(1<<EERE);
+    eeprom_n_read++;
+  }
+  if (eeprom_control & (1<<EEPE)) {
+    switch (EEPROM_MODE(eeprom_control)) {
+      case 0: eeprom[eeprom_address] = eeprom_data; break;
+      case 1: eeprom[eeprom_address] = 0xff; break;
+      case 2: eeprom[eeprom_address] &= eeprom_data; break;
+    }
+    eeprom_control &= (1<<EERIE);
+    eeprom_n_written++;
+  }
+}
+static uint8_t *eeprom_control_register() { eeprom_complete(); return(&eeprom_control); }
+static uint8_t *eeprom_data_register() { eeprom_complete(); return(&eeprom_data); }
+#define EECR (*eeprom_control_register())
+#define EEDR (*eeprom_data_register())
+#define EEAR eeprom_address
+
+#include "../eeprom.c"
+#include "../journal.c"
+#include "../ps_settings.c"
+
+#define IMAGE_OFFSET (PS_SETTINGS_EEPROM_OFFSET+PS_SETTINGS_EEPROM_PARAMETERS_OFFSET)
+
+static const float test_values[PS_SETTINGS_NUM_PARAMETERS] = { 1.25, 500.0, 100.0, 200.0, 300.0, 50.0, 1.0 };
+static unsigned long n_failed = 0;
+
+#define CHECK(condition) do { if (!(condition)) { n_failed++; printf("FAIL %s:%d: %s\n", test_name, __LINE__, #condition); } } while (0)
+
+
+// Powers up. Any queued EEPROM writes are completed first, as they would be before power off.
+static void boot()
+{
+  eeprom_flush();
+  eeprom_n_written = 0;
+  journal_init();
+  eeprom_n_read = 0; // The journal scan is part of settings_init(). Count ps_settings_init() alone.
+  ps_settings_init();
+  eeprom_flush();
+}
+
+
+static void eeprom_erase()
+{
+  eeprom_flush();
+  memset(eeprom, 0xff, sizeof(eeprom));
+}
+
+
+static void write_header(uint8_t revision, uint8_t size)
+{
+  memcpy_to_eeprom_no_checksum(PS_SETTINGS_EEPROM_OFFSET, "Inventables Settings          ",
+                               PS_SETTINGS_EEPROM_REVISION_OFFSET);
+  eeprom_put_char(PS_SETTINGS_EEPROM_OFFSET+PS_SETTINGS_EEPROM_REVISION_OFFSET, revision);
+  eeprom_put_char(PS_SETTINGS_EEPROM_OFFSET+PS_SETTINGS_EEPROM_PARAM_SIZE_OFFSET, size);
+}
+
+
+// Packs values in parameter order at their type size, as the firmware stores them.
+static uint8_t encode_image(const float *values, uint8_t *data)
+{
+  uint8_t parameter;
+  for (parameter=0; parameter<PS_SETTINGS_NUM_PARAMETERS; parameter++) {
+    encode_value(pgm_read_byte(&gCarvinParameterMap[parameter].type), values[parameter],
+                 data + get_offset(parameter));
+  }
+  return(get_offset(PS_SETTINGS_NUM_PARAMETERS));
+}
+
+
+static void write_image_rev2(const float *values, uint8_t size)
+{
+  uint8_t data[PS_SETTINGS_STORAGE_MAX_SIZE];
+  uint8_t crc = 0;
+  uint8_t idx;
+  encode_image(values, data);
+  for (idx=0; idx<size; idx++) { crc = _crc8_ccitt_update(crc, data[idx]); }
+  write_header(2, size);
+  memcpy_to_eeprom_no_checksum(IMAGE_OFFSET, (char*)data, size);
+  eeprom_put_char(IMAGE_OFFSET+size, crc);
+}
+
+
+static float default_value(uint8_t parameter)
+{
+  ps_settings_map_element element;
+  ps_settings_get_element(parameter, &element);
+  return(element.default_value);
+}
+
+
+static bool values_are(const float *expected)
+{
+  float value;
+  uint8_t parameter;
+  for (parameter=0; parameter<PS_SETTINGS_NUM_PARAMETERS; parameter++) {
+    ps_settings_get_value(parameter, &value);
+    if (value != expected[parameter]) { return(false); }
+  }
+  return(true);
+}
+
+
+// The stored image is in the current format, holds the expected values, and boots without writing.
+static bool image_is_current(const float *expected)
+{
+  uint8_t data[PS_SETTINGS_STORAGE_MAX_SIZE];
+  uint8_t size = encode_image(expected, data);
+  uint8_t crc = 0;
+  uint8_t idx;
+  if (eeprom[PS_SETTINGS_EEPROM_OFFSET+PS_SETTINGS_EEPROM_REVISION_OFFSET] != PS_SETTINGS_VERSION) { return(false); }
+  if (eeprom[PS_SETTINGS_EEPROM_OFFSET+PS_SETTINGS_EEPROM_PARAM_SIZE_OFFSET] != size) { return(false); }
+  if (memcmp(&eeprom[IMAGE_OFFSET], data, size)) { return(false); }
+  for (idx=0; idx<size; idx++) { crc = _crc8_ccitt_update(crc, data[idx]); }
+  if (eeprom[IMAGE_OFFSET+size] != crc) { return(false); }
+  boot();
+  return((eeprom_n_written == 0) && values_are(expected));
+}
+
+
+static void test_blank()
+{
+  const char *test_name = "blank";
+  float defaults[PS_SETTINGS_NUM_PARAMETERS];
+  uint8_t parameter;
+  for (parameter=0; parameter<PS_SETTINGS_NUM_PARAMETERS; parameter++) {
+    defaults[parameter] = default_value(parameter);
+  }
+  eeprom_erase();
+  boot();
+  CHECK(values_are(defaults));
+  CHECK(memcmp(&eeprom[PS_SETTINGS_EEPROM_OFFSET], "Inventables Settings          ",
+               PS_SETTINGS_EEPROM_REVISION_OFFSET) == 0);
+  CHECK(image_is_current(defaults));
+}
+
+
+static void test_rev2()
+{
+  const char *test_name = "rev2";
+  eeprom_erase();
+  write_image_rev2(test_values, get_offset(PS_SETTINGS_NUM_PARAMETERS));
+  boot();
+  CHECK(eeprom_n_written == 0);
+  CHECK(values_are(test_values));
+  printf("ps_settings_init() of a valid image reads %lu EEPROM bytes, writes %lu\n", eeprom_n_read, eeprom_n_written);
+}
+
+
+static void test_rev1()
+{
+  const char *test_name = "rev1";
+  float expected[PS_SETTINGS_NUM_PARAMETERS];
+  float spindle_i_max = 2.5;
+  uint8_t parameter;
+  for (parameter=0; parameter<PS_SETTINGS_NUM_PARAMETERS; parameter++) {
+    expected[parameter] = default_value(parameter);
+  }
+  expected[PS_SETTING_SPINDLE_I_MAX] = spindle_i_max;
+
+  // Revision 1 firmware stored the single spindle current float with the Grbl checksum.
+  eeprom_erase();
+  write_header(1, sizeof(spindle_i_max));
+  memcpy_to_eeprom_with_checksum(IMAGE_OFFSET, (char*)&spindle_i_max, sizeof(spindle_i_max));
+  boot();
+  CHECK(values_are(expected));
+  CHECK(image_is_current(expected));
+
+  // A bad Grbl checksum leaves the defaults.
+  // NOTE: The Grbl checksum shifts with a logical OR, so it effectively covers the last byte only.
+  eeprom_erase();
+  write_header(1, sizeof(spindle_i_max));
+  memcpy_to_eeprom_with_checksum(IMAGE_OFFSET, (char*)&spindle_i_max, sizeof(spindle_i_max));
+  eeprom_put_char(IMAGE_OFFSET+sizeof(spindle_i_max)-1,
+                  eeprom_get_char(IMAGE_OFFSET+sizeof(spindle_i_max)-1) ^ 0x01);
+  boot();
+  expected[PS_SETTING_SPINDLE_I_MAX] = default_value(PS_SETTING_SPINDLE_I_MAX);
+  CHECK(values_are(expected));
+  CHECK(image_is_current(expected));
+}
+
+
+static void test_upgrade()
+{
+  const char *test_name = "upgrade";
+  float expected[PS_SETTINGS_NUM_PARAMETERS];
+  uint8_t parameter;
+  uint8_t size = get_offset(PS_SETTING_SG_HOMING_THRESHOLD_X); // Image of older firmware.
+  for (parameter=0; parameter<PS_SETTINGS_NUM_PARAMETERS; parameter++) {
+    expected[parameter] = (parameter < PS_SETTING_SG_HOMING_THRESHOLD_X) ? test_values[parameter] :
+                          default_value(parameter);
+  }
+  eeprom_erase();
+  write_image_rev2(test_values, size);
+  boot();
+  CHECK(values_are(expected));
+  CHECK(image_is_current(expected));
+}
+
+
+static void test_bad_crc()
+{
+  const char *test_name = "bad crc";
+  float defaults[PS_SETTINGS_NUM_PARAMETERS];
+  uint8_t size = get_offset(PS_SETTINGS_NUM_PARAMETERS);
+  uint8_t parameter, idx;
+  for (parameter=0; parameter<PS_SETTINGS_NUM_PARAMETERS; parameter++) {
+    defaults[parameter] = default_value(parameter);
+  }
+
+  // Every single bit error in the values or the CRC restores the defaults, in the current format.
+  for (idx=0; idx<=size; idx++) {
+    eeprom_erase();
+    write_image_rev2(test_values, size);
+    eeprom_put_char(IMAGE_OFFSET+idx, eeprom_get_char(IMAGE_OFFSET+idx) ^ (1 << (idx & 7)));
+    boot();
+    CHECK(values_are(defaults));
+    CHECK(image_is_current(defaults));
+  }
+
+  // A damaged header is a blank EEPROM.
+  eeprom_erase();
+  write_image_rev2(test_values, size);
+  eeprom_put_char(PS_SETTINGS_EEPROM_OFFSET, 'i');
+  boot();
+  CHECK(values_are(defaults));
+  CHECK(image_is_current(defaults));
+}
+
+
+static void test_journal()
+{
+  const char *test_name = "journal";
+  float expected[PS_SETTINGS_NUM_PARAMETERS];
+  uint8_t image[PS_SETTINGS_IMAGE_MAX_SIZE];
+  uint8_t size = get_offset(PS_SETTINGS_NUM_PARAMETERS);
+  uint8_t stored[PS_SETTINGS_STORAGE_MAX_SIZE];
+  memcpy(expected, test_values, sizeof(expected));
+
+  // A single change is journaled. The image is left as is and the journal overlays it on boot.
+  eeprom_erase();
+  write_image_rev2(test_values, size);
+  boot();
+  memcpy(stored, &eeprom[IMAGE_OFFSET], size);
+  CHECK(ps_settings_set_value(PS_SETTING_SPINDLE_I_MAX, 2.0) == PS_SETTINGS_OK);
+  CHECK(ps_settings_set_value(PS_SETTING_SG_LOAD_ALARM, 75.0) == PS_SETTINGS_OK);
+  CHECK(ps_settings_set_value(PS_SETTING_SPINDLE_I_MAX, 2.25) == PS_SETTINGS_OK);
+  eeprom_flush();
+  CHECK(memcmp(stored, &eeprom[IMAGE_OFFSET], size) == 0);
+  expected[PS_SETTING_SPINDLE_I_MAX] = 2.25;
+  expected[PS_SETTING_SG_LOAD_ALARM] = 75.0;
+  boot();
+  CHECK(eeprom_n_written == 0);
+  CHECK(values_are(expected));
+
+  // Rejected values change nothing.
+  CHECK(ps_settings_set_value(PS_SETTING_SPINDLE_I_MAX, 3.5) == PS_SETTINGS_OUT_OF_RANGE);
+  CHECK(ps_settings_set_value(PS_SETTING_SPINDLE_I_MAX, NAN) == PS_SETTINGS_OUT_OF_RANGE);
+  boot();
+  CHECK(values_are(expected));
+
+  // Journaled values also overlay an image that failed its CRC, and go into the rewritten image.
+  eeprom_put_char(IMAGE_OFFSET, eeprom_get_char(IMAGE_OFFSET) ^ 0x80);
+  boot();
+  for (uint8_t parameter=0; parameter<PS_SETTINGS_NUM_PARAMETERS; parameter++) {
+    if ((parameter != PS_SETTING_SPINDLE_I_MAX) && (parameter != PS_SETTING_SG_LOAD_ALARM)) {
+      expected[parameter] = default_value(parameter);
+    }
+  }
+  CHECK(values_are(expected));
+  CHECK(image_is_current(expected));
+
+  // A bulk load replaces the image and the journaled values with it.
+  memcpy(expected, test_values, sizeof(expected));
+  ps_settings_restore();
+  for (uint8_t parameter=0; parameter<PS_SETTINGS_NUM_PARAMETERS; parameter++) {
+    ps_settings_set_value(parameter, test_values[parameter]);
+  }
+  ps_settings_get_image(image);
+  ps_settings_restore();
+  ps_settings_set_value(PS_SETTING_SPINDLE_I_MAX, 0.5);
+  CHECK(ps_settings_load_image(image, ps_settings_get_image_size()) == PS_SETTINGS_OK);
+  boot();
+  CHECK(values_are(expected));
+  CHECK(image_is_current(expected));
+
+  // Many changes wrap the journal. The newest value of each key stays in effect.
+  for (uint16_t idx=0; idx<10*JOURNAL_N_SLOTS; idx++) {
+    ps_settings_set_value(PS_SETTING_SG_LOAD_ALARM, idx & 0x3ff);
+  }
+  expected[PS_SETTING_SG_LOAD_ALARM] = (10*JOURNAL_N_SLOTS-1) & 0x3ff;
+  boot();
+  CHECK(values_are(expected));
+}
+
+
+int main()
+{
+  test_blank();
+  test_rev2();
+  test_rev1();
+  test_upgrade();
+  test_bad_crc();
+  test_journal();
+  printf("%lu failed\n", n_failed);
+  return(n_failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
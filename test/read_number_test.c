@@ -0,0 +1,150 @@
+/*
+  read_number_test.c - host round-trip test of read_number() and read_float() against strtod()
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  Runs on the host, not the controller. From the repository root:
+
+    cc -O2 -o read_number_test test/read_number_test.c -lm && ./read_number_test
+
+  Every significand up to 6 digits is formatted with 0 to 4 fraction digits, both signs. Each
+  string must parse to within 2 ulp of the float of strtod(), like the old per-digit read_float()
+  did. The command word integer (low byte of the truncated integer part, as the g-code parser
+  stores it) and the rounded hundredths must match the double value. Reports
+  the parse time per word of read_float() and strtod() as a rough host benchmark.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+// Compile nuts_bolts.c without the AVR side of grbl.h. Only the number parsing is tested.
+#define grbl_h
+#include "../nuts_bolts.h"
+#define DWELL_TIME_STEP 50
+#define SUSPEND_RESTART_RETRACT 0
+#define _delay_ms(ms)
+#define _delay_us(us)
+static struct { uint8_t abort; uint8_t suspend; } sys;
+static void protocol_execute_realtime() {}
+static void protocol_exec_rt_system() {}
+#include "../nuts_bolts.c"
+
+#define MAX_SIGNIFICAND 1000000
+#define MAX_FRACTION_DIGITS 4
+#define MAX_ULP 2
+
+
+static int32_t float_ulp_distance(float a, float b)
+{
+  int32_t ia, ib;
+  memcpy(&ia, &a, sizeof(ia));
+  memcpy(&ib, &b, sizeof(ib));
+  if (ia < 0) { ia = INT32_MIN - ia; } // Map to a monotonic integer line.
+  if (ib < 0) { ib = INT32_MIN - ib; }
+  return(labs((long)ia - (long)ib));
+}
+
+
+static void format_number(char *line, uint32_t significand, uint8_t n_fraction, bool negative)
+{
+  uint32_t scale = 1;
+  uint8_t idx;
+  for (idx=0; idx<n_fraction; idx++) { scale *= 10; }
+  if (n_fraction) {
+    sprintf(line, "%s%lu.%0*lu", negative ? "-" : "", (unsigned long)(significand/scale),
+            n_fraction, (unsigned long)(significand%scale));
+  } else {
+    sprintf(line, "%s%lu", negative ? "-" : "", (unsigned long)significand);
+  }
+}
+
+
+// Hundredths rounded on the third fraction digit in decimal. Exact .xx5 ties may round either
+// way in binary, so those only need to be within one.
+static bool mantissa_ok(const char *line, double value, uint8_t mantissa)
+{
+  double frac = fabs(value) - trunc(fabs(value));
+  long expected = lround(100.0*frac);
+  const char *dot = strchr(line, '.');
+  if (dot && (strlen(dot) >= 4) && (dot[3] == '5') && (strspn(dot+4, "0") == strlen(dot+4))) {
+    return(labs(expected - mantissa) <= 1);
+  }
+  return(expected == mantissa);
+}
+
+
+int main()
+{
+  char line[24];
+  uint32_t significand;
+  uint8_t n_fraction, negative, char_counter;
+  number_t number;
+  float value = 0;
+  double expected;
+  unsigned long n_tested = 0, n_failed = 0;
+
+  for (negative=0; negative<2; negative++) {
+    for (n_fraction=0; n_fraction<=MAX_FRACTION_DIGITS; n_fraction++) {
+      for (significand=0; significand<MAX_SIGNIFICAND; significand++) {
+        format_number(line, significand, n_fraction, negative);
+        expected = strtod(line, NULL);
+        char_counter = 0;
+        n_tested++;
+        if (!read_number(line, &char_counter, &number) || (line[char_counter] != 0)) {
+          if (n_failed++ < 10) { printf("FAIL %s: not parsed\n", line); }
+          continue;
+        }
+        value = number_to_float(&number);
+        if ((float_ulp_distance(value, (float)expected) > MAX_ULP) ||
+            (number.isnegative != negative) ||
+            (number.int_value != (uint8_t)(uint32_t)trunc(fabs(expected))) ||
+            !mantissa_ok(line, expected, number.mantissa)) {
+          if (n_failed++ < 10) {
+            printf("FAIL %s: %.9g (strtod %.9g) int %lu mantissa %u\n", line, value, expected,
+                   (unsigned long)number.int_value, number.mantissa);
+          }
+        }
+      }
+    }
+  }
+  printf("%lu numbers, %lu failed\n", n_tested, n_failed);
+
+  // Rough host benchmark over a fixed set of typical g-code values.
+  const char *words[] = { "12.5", "-0.25", "100", "3.1416", "-45.0625", "0.001", "2500", "7" };
+  clock_t start;
+  volatile float sink = 0;
+  unsigned long idx;
+  start = clock();
+  for (idx=0; idx<8000000; idx++) {
+    char_counter = 0;
+    read_float((char*)words[idx&7], &char_counter, &value);
+    sink += value;
+  }
+  printf("read_float: %.1f ns/word\n", 1e9*(clock()-start)/CLOCKS_PER_SEC/8000000.0);
+  start = clock();
+  for (idx=0; idx<8000000; idx++) { sink += strtod(words[idx&7], NULL); }
+  printf("strtod:     %.1f ns/word\n", 1e9*(clock()-start)/CLOCKS_PER_SEC/8000000.0);
+
+  return(n_failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,38 @@
+/*
+  util/crc16.h - host stand-in for the avr-libc CRC routines, for the tests in this directory
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef util_crc16_h
+#define util_crc16_h
+
+#include <stdint.h>
+
+// CRC-8 CCITT, polynomial 0x07, as the reference C code in the avr-libc documentation.
+static inline uint8_t _crc8_ccitt_update(uint8_t crc, uint8_t data)
+{
+  uint8_t idx;
+  crc ^= data;
+  for (idx=0; idx<8; idx++) {
+    if (crc & 0x80) { crc = (crc << 1) ^ 0x07; }
+    else { crc <<= 1; }
+  }
+  return(crc);
+}
+
+#endif
@@ -0,0 +1,29 @@
+/*
+  util/delay.h - host stand-in for the avr-libc busy-wait delays, for the tests in this directory
+  Part of Grbl
+
+  Copyright (c) 2017 Inventables Inc.
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Time doesn't pass on the host. Delays return at once.
+
+#ifndef util_delay_h
+#define util_delay_h
+
+#define _delay_ms(ms)
+#define _delay_us(us)
+
+#endif